@@ -0,0 +1,99 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+// Measure the memory of a DyckGraph and the time of DyckGraph::qirunAlgorithm()
+// on synthetic graphs, without LLVM, so that builds of lib/DyckGraph can be
+// compared where canary cannot be built, e.g.
+//   g++ -O2 -DNDEBUG -std=c++11 -I../include dyckgraph-perf.cpp ../lib/DyckGraph/*.cpp -lpthread
+//   ./dyckgraph-perf 1000000       # a pointer graph of 2M vertices
+//   ./dyckgraph-perf 100000 hub    # 100K values merged along 64 high-degree vertices
+// It prints the vertices, the equivalent classes, the memory (KB) used by the graph
+// before and after the algorithm, the time (s) of the algorithm and the peak RSS (KB).
+
+#include "DyckGraph/DyckGraph.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+static long residentKB() {
+	long pages = 0, resident = 0;
+	FILE* f = fopen("/proc/self/statm", "r");
+	if (f == NULL || fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+		resident = 0;
+	}
+	if (f != NULL) {
+		fclose(f);
+	}
+	return resident * 4;
+}
+
+static DyckVertex* vertex(DyckGraph& g, unsigned long value) {
+	return g.retrieveDyckVertex((void*) value).first;
+}
+
+/// Each of the n pointers has a deref edge (label 1) to its object, each object has
+/// a field edge (label 2 or 3) to a random pointer, and one pointer in 16 may point
+/// to the object of another one, like after a store.
+static void buildPointerGraph(DyckGraph& g, unsigned n) {
+	for (unsigned i = 1; i <= n; i++) {
+		vertex(g, i);
+	}
+	for (unsigned i = 1; i <= n; i++) {
+		DyckVertex* object = vertex(g, n + i);
+		vertex(g, i)->addTarget(object, (void*) 1L);
+		DyckVertex* field = vertex(g, rand() % n + 1);
+		object->addTarget(field, (void*) (2L + rand() % 2));
+		if (rand() % 16 == 0) {
+			vertex(g, i)->addTarget(vertex(g, n + rand() % n + 1), (void*) 1L);
+		}
+	}
+}
+
+/// 64 hubs point to all the n values with the same label, like an array of pointers,
+/// so that all the values are merged, and random values point to the hubs with 8
+/// labels, so that the hubs are merged while they have thousands of edges.
+static void buildHubGraph(DyckGraph& g, unsigned n) {
+	for (unsigned i = 1; i <= n; i++) {
+		vertex(g, i);
+	}
+	for (unsigned i = 1; i <= n; i++) {
+		DyckVertex* hub = vertex(g, 2 * n + 1 + i % 64);
+		hub->addTarget(vertex(g, i), (void*) 4L);
+		DyckVertex* source = vertex(g, rand() % n + 1);
+		source->addTarget(hub, (void*) (5L + rand() % 8));
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2 || atoi(argv[1]) <= 0) {
+		fprintf(stderr, "Usage: %s <number of values> [hub]\n", argv[0]);
+		return 1;
+	}
+	unsigned n = atoi(argv[1]);
+	bool hub = argc > 2 && !strcmp(argv[2], "hub");
+
+	srand(1);
+	long base = residentKB();
+	DyckGraph g;
+	if (hub) {
+		buildHubGraph(g, n);
+	} else {
+		buildPointerGraph(g, n);
+	}
+	long built = residentKB() - base;
+	unsigned vertices = g.numVertices();
+
+	auto start = std::chrono::steady_clock::now();
+	g.qirunAlgorithm();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	long solved = residentKB() - base;
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	printf("%u\t%u\t%ld\t%ld\t%.3f\t%ld\n", vertices, g.numEquivalentClasses(), built, solved, seconds, usage.ru_maxrss);
+	return 0;
+}
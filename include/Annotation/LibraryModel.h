@@ -0,0 +1,79 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#ifndef LIBRARYMODEL_H
+#define LIBRARYMODEL_H
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MD5.h"
+
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+/// An effect of a call to a library function, whose body is not available.
+/// The operands are the indices of the arguments, or Ret for the return value.
+struct LibraryEffect {
+	enum Kind {
+		ALIAS, ///< first aliases second
+		CONTENT_ALIAS, ///< the memory first points to aliases the memory second points to
+		KEY_VALUE, ///< first is a key, e.g. of pthread_setspecific, and second is its value
+		THREAD_SPAWN, ///< first is called with second in a new thread
+		READONLY_ARG ///< the memory first points to is only read, used by LibcAnnotation
+	};
+
+	static const int Ret = -1;
+	static const int AnyArgs = -1;
+
+	Kind kind;
+
+	/// the effect only applies to the calls with numArgs arguments, unless it is AnyArgs
+	int numArgs;
+
+	int first;
+	int second;
+};
+
+/// The models of library functions: the built-in ones of libc and pthread, and the
+/// ones in the file given by -library-models. Each line of the file is
+///
+///     name num-args kind first [second]
+///
+/// where num-args is a number or *, kind is one of alias, content-alias, key-value,
+/// thread-spawn and readonly, and an operand is the index of an argument from 0
+/// or ret. '#' starts a comment. The lines of a function in the file replace its
+/// built-in models, e.g.
+///
+///     # void* slab_dup(void* src, size_t n)
+///     slab_dup 2 content-alias ret 0
+class LibraryModels {
+private:
+	StringMap<vector<LibraryEffect> > models;
+
+	LibraryModels();
+
+	void add(const char* name, LibraryEffect::Kind kind, int numArgs, int first, int second = LibraryEffect::Ret);
+
+	/// Return false and set error if the file cannot be parsed.
+	bool load(const char* file, string& error);
+
+public:
+	/// The models are built once and only read after that.
+	static const LibraryModels& get();
+
+	/// Return NULL if the function has no model.
+	const vector<LibraryEffect>* lookup(StringRef name) const {
+		auto it = models.find(name);
+		return it == models.end() ? NULL : &it->second;
+	}
+
+	/// Add all the models to the hasher in the order of the names.
+	void hash(MD5& hasher) const;
+};
+
+#endif
@@ -10,10 +10,14 @@
 #ifndef AAANALYZER_H
 #define	AAANALYZER_H
 
+#include "Annotation/LibraryModel.h"
 #include "DyckAA/EdgeLabel.h"
 #include "DyckAA/DyckAliasAnalysis.h"
 #include "DyckAA/ProgressBar.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/MD5.h"
 #include <map>
+#include <tuple>
 #include <unordered_map>
 
 using namespace std;
@@ -26,6 +30,16 @@ typedef struct FunctionTypeNode {
 	set<Function *> compatibleFuncs;
 } FunctionTypeNode;
 
+/// What the inter-procedural analysis indexes by a rep, which is
+/// moved to the surviving rep when the rep is merged into another one.
+typedef struct RepInfo {
+	/// the pointer calls whose called values are in the equivalent set of the rep
+	vector<pair<PointerCall*, DyckCallGraphNode*> > pointerCalls;
+	/// the address-taken functions in the equivalent set, by the roots of the
+	/// function type groups whose compatibleFuncs contain them
+	map<FunctionTypeNode*, set<Function*> > functions;
+} RepInfo;
+
 class AAAnalyzer {
 private:
 	Module* module;
@@ -35,10 +49,68 @@ private:
 
 private:
 	map<Type*, FunctionTypeNode*> functionTyNodeMap;
-	set<FunctionTypeNode *> tyroots;
+	/// the compatibility key -> the root of the types with the key, see getCompatibilityKey()
+	unordered_map<uint64_t, FunctionTypeNode *> tyroots;
 
 	DyckAA::ProgressBar PB;
 
+	/// the library models of the functions without bodies, NULL if a function has none
+	DenseMap<Function*, const vector<LibraryEffect>*> lib_models;
+
+	/// the functions to analyze, NULL if all of them are analyzed,
+	/// see DyckAliasAnalysis::computeRegion()
+	const set<Function*>* region;
+
+private:
+	/// If it is not NULL, this analyzer is a worker of parallel_intra_procedure_analysis(),
+	/// which analyzes a function into its own graph. What touches the data shared by
+	/// the functions is recorded below, and it is done by the owner when the graph of
+	/// the function is merged into the owner's graph.
+	AAAnalyzer* owner;
+
+	/// the constants wrapped by the worker, which are analyzed by the owner
+	vector<Value*> deferred_constants;
+
+	/// the casts between function pointer types, see combineFunctionGroups()
+	vector<Instruction*> deferred_casts;
+
+	/// the implicit calls of thread spawning functions like pthread_create,
+	/// i.e. (the function, the called value, the argument)
+	vector<std::tuple<Function*, Value*, Value*> > deferred_implicit_calls;
+
+	/// the number of instructions analyzed by the worker
+	long num_insts;
+
+	/// the number of the field edges collapsed by -dyckaa-field-limit
+	long num_collapsed_fields;
+
+	/// the number of the constant aggregates analyzed in bulk, and the number of the
+	/// aggregates nested in them, see handle_constant_aggregate()
+	/// @{
+	long num_bulk_aggregates;
+	long num_bulk_elements;
+	/// @}
+
+	/// the directory of the summary cache, which is empty if it is not used, see DyckSummary
+	string summary_dir;
+
+	/// the number of functions whose summaries are loaded from or saved to the cache
+	/// @{
+	long num_loaded_summaries;
+	long num_saved_summaries;
+	/// @}
+
+private:
+	/// The calls found since inter_procedure_analysis() last took them, e.g. the
+	/// implicit calls of pthread_create when it is called via a pointer.
+	/// @{
+	vector<pair<CommonCall*, DyckCallGraphNode*> > new_common_calls;
+	vector<pair<PointerCall*, DyckCallGraphNode*> > new_pointer_calls;
+	/// @}
+
+	/// the index of a rep -> its RepInfo, which is only used in inter_procedure_analysis()
+	unordered_map<unsigned, RepInfo> rep_infos;
+
 public:
 	AAAnalyzer(Module* m, DyckAliasAnalysis* a, DyckGraph* d, DyckCallGraph* cg);
 	~AAAnalyzer();
@@ -52,7 +124,39 @@ public:
 	void intra_procedure_analysis();
 	void inter_procedure_analysis();
 
+	/// Add the options that change the result of the analysis to the hasher,
+	/// see DyckResultCache.
+	static void hashOptions(MD5& hasher);
+
+	/// Only analyze the functions in the region, whose calls out of the region are
+	/// not bound to them.
+	void setRegion(const set<Function*>* r) {
+		region = r;
+	}
+
+	/// Return false if the result of a function may depend on the functions that are
+	/// not analyzed in other ways than the values they share, e.g. the casts of the
+	/// function pointers in them combine the function groups, see setRegion().
+	static bool supportsRegion();
+
 private:
+	/// A worker of parallel_intra_procedure_analysis() with its own graph.
+	AAAnalyzer(AAAnalyzer* o, DyckGraph* d);
+
+	void analyze_function(Function* f, DyckCallGraphNode* df);
+
+	/// Analyze the function into the worker's graph and normalize it, or load the
+	/// graph from the summary of the function if it is cached.
+	void build_function_graph(Function* f, DyckCallGraphNode* df);
+
+	/// Analyze the functions by the threads, each of which into its own graph. The
+	/// graphs are merged into this analyzer's graph in the order of the functions.
+	void parallel_intra_procedure_analysis(unsigned threads);
+
+	/// Merge the graph of a worker into this analyzer's graph, and do what the worker
+	/// has deferred.
+	void merge_worker(AAAnalyzer* worker);
+
 	void printNoAliasedPointerCalls();
 
 private:
@@ -60,16 +164,27 @@ private:
 	void handle_instrinsic(Instruction *inst);
 	void handle_extract_insert_value_inst(Value* aggValue, Type* aggTy, ArrayRef<unsigned>& indices, Value* insertedOrExtractedValue);
 	void handle_extract_insert_elmt_inst(Value* vec, Value* elmt);
+
+	/// Analyze the elements of a large constant array or struct nested in the outermost
+	/// one at the path of fields. A nested aggregate is analyzed into the vertex of its
+	/// place rather than its own one, e.g. the elements of an array into the vertex of
+	/// the array, and it gets no field vertices of its own.
+	void handle_constant_aggregate(Constant* outermost, vector<long>& path, Constant* agg);
 	void handle_invoke_call_inst(Instruction * ret, Value* cv, vector<Value*>* args, DyckCallGraphNode * parent);
 	void handle_lib_invoke_call_inst(Value* ret, Function* f, vector<Value*>* args, DyckCallGraphNode* parent);
 
 private:
-	bool handle_pointer_function_calls(DyckCallGraphNode* caller, int counter);
+	/// Match the pointer call with the functions newly found in the equivalent set of
+	/// its called value. Return true if any is found.
+	bool handle_pointer_function_call(PointerCall* pcall, DyckCallGraphNode* caller);
+
+	/// Move the RepInfo of the merged vertex to the rep, see DyckGraph::takeMerges().
+	void merge_rep_info(unsigned rep, unsigned merged);
 	void handle_common_function_call(Call* c, DyckCallGraphNode* caller, DyckCallGraphNode* callee);
 
 private:
-	int isCompatible(FunctionType * t1, FunctionType * t2);
-	set<Function*>* getCompatibleFunctions(FunctionType * fty);
+	/// Two function types are compatible iff their keys are the same.
+	uint64_t getCompatibilityKey(FunctionType * fty);
 
 	FunctionTypeNode* initFunctionGroup(FunctionType* fty);
 	void initFunctionGroups();
@@ -77,7 +192,10 @@ private:
 	void combineFunctionGroups(FunctionType * ft1, FunctionType* ft2);
 
 private:
-	DyckVertex* addField(DyckVertex* val, long fieldIndex, DyckVertex* field);
+	/// Add the field edge of the index from val to field, which is created if it is null,
+	/// and return the field. The fields from -dyckaa-field-limit are one field, and the
+	/// index of its label is put into *labelIndex if it is given.
+	DyckVertex* addField(DyckVertex* val, long fieldIndex, DyckVertex* field, long* labelIndex = nullptr);
 	DyckVertex* addPtrTo(DyckVertex* address, DyckVertex* val);
 	DyckVertex* makeAlias(DyckVertex* x, DyckVertex* y);
 	void makeContentAlias(DyckVertex* x, DyckVertex* y);
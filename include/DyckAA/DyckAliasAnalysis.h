@@ -23,14 +23,19 @@
 #include "llvm/IR/InlineAsm.h"
 
 #include "DyckGraph/DyckGraph.h"
+#include "DyckGraph/DyckReachability.h"
 #include "DyckCG/DyckCallGraph.h"
 #include "DyckAA/AAAnalyzer.h"
 
 #include <set>
+#include <stack>
+#include <unordered_set>
 
 using namespace llvm;
 using namespace std;
 
+class DyckResultCache;
+
 class DyckAliasAnalysis: public ModulePass, public AliasAnalysis {
 public:
 	static char ID; // Class identification, replacement for typeinfo
@@ -53,7 +58,10 @@ public:
 		return alias(V1, UnknownSize, V2, UnknownSize);
 	}
 
-	/// Get the may/must alias set.
+	/// Get the may/must alias set. With -dyckaa-region, the set of a value whose
+	/// result may differ from the one of the whole analysis, see isSolved(), is the
+	/// one of the region, e.g. only the value itself out of the region, and it may
+	/// miss some aliases; alias() answers MayAlias for such a value.
 	virtual const set<Value*>* getAliasSet(Value * ptr) const;
 
 	virtual ModRefResult getModRefInfo(ImmutableCallSite CS, const Location &Loc) {
@@ -100,35 +108,66 @@ private:
 	DyckGraph* dyck_graph;
 	DyckCallGraph * call_graph;
 
+	/// the reachability via the offset edges among the reps, see isPartialAlias()
+	DyckReachability* offset_reach;
+
+	/// The roots of getEscapedPointersTo(), which are computed from the call graph
+	/// before it is released, and the results, which are shared by all the clients.
+	/// @{
+	vector<DyckVertex*> global_escape_roots;
+	map<Function*, vector<DyckVertex*> > call_escape_roots;
+	map<Function*, set<DyckVertex*> > escaped_to_cache;
+	/// @}
+
 	std::set<Function*> mem_allocas;
 	map<DyckVertex*, std::vector<Value*>*> vertexMemAllocaMap;
 
+	/// the reps of the functions in mem_allocas
+	std::unordered_set<DyckVertex*> mem_alloca_reps;
+	/// csr id -> the result of getDefaultPointstoMemAlloca(), built by indexMemAllocas()
+	vector<std::vector<Value*> > csr_mem_allocas;
+
+	/// The region pre-analysis of -dyckaa-region, see computeRegion(), which is off if
+	/// the region is empty. Only the values whose results are the same as the ones of
+	/// the whole analysis are answered, see isSolved().
+	/// @{
+	std::set<Function*> region_funcs;
+	/// the constants and the global values used both in and out of the region
+	vector<Constant*> region_boundary;
+	/// the values whose equivalent sets may be changed by the whole analysis, and the
+	/// values bound by the calls of the functions and the pointer calls in the region,
+	/// see collectRegionSeeds()
+	/// @{
+	vector<Value*> region_seeds;
+	vector<pair<Value*, vector<Value*> > > region_callees;
+	vector<pair<Value*, vector<Value*> > > region_pointer_calls;
+	/// @}
+	/// csr id -> true if the equivalent set of the rep and the ones reachable from it
+	/// are the same as the ones of the whole analysis
+	vector<bool> region_stable;
+	/// the values of the module without vertices, e.g. the ones out of the region, and
+	/// all the allocation sites, which are used by the conservative answers
+	/// @{
+	set<Value*> region_rest;
+	vector<Value*> region_mem_allocas;
+	/// @}
+	/// @}
+
 private:
 	friend class AAAnalyzer;
 
-	EdgeLabel * DEREF_LABEL;
-	map<long, EdgeLabel*> OFFSET_LABEL_MAP;
-	map<long, EdgeLabel*> INDEX_LABEL_MAP;
+	/// the labels of the edges in dyck_graph
+	EdgeLabel edge_labels;
+
+	void* DEREF_LABEL;
 
 private:
-	EdgeLabel* getOrInsertOffsetEdgeLabel(long offset) {
-		if (OFFSET_LABEL_MAP.count(offset)) {
-			return OFFSET_LABEL_MAP[offset];
-		} else {
-			EdgeLabel* ret = new PointerOffsetEdgeLabel(offset);
-			OFFSET_LABEL_MAP.insert(pair<long, EdgeLabel*>(offset, ret));
-			return ret;
-		}
+	void* getOrInsertOffsetEdgeLabel(long offset) {
+		return edge_labels.getOrInsertOffsetLabel(offset);
 	}
 
-	EdgeLabel* getOrInsertIndexEdgeLabel(long offset) {
-		if (INDEX_LABEL_MAP.count(offset)) {
-			return INDEX_LABEL_MAP[offset];
-		} else {
-			EdgeLabel* ret = new FieldIndexEdgeLabel(offset);
-			INDEX_LABEL_MAP.insert(pair<long, EdgeLabel*>(offset, ret));
-			return ret;
-		}
+	void* getOrInsertIndexEdgeLabel(long offset) {
+		return edge_labels.getOrInsertIndexLabel(offset);
 	}
 
 private:
@@ -137,6 +176,41 @@ private:
 	/// extractvalue instruction from the object VA points to.
 	bool isPartialAlias(DyckVertex *VA, DyckVertex *VB);
 
+	/// Build offset_reach for the CSR of dyck_graph.
+	void buildOffsetReachability();
+
+	/// Analyze the module, or the functions in region_funcs if it is not empty, unless
+	/// the result has been loaded, and index the result for the queries.
+	void analyze(Module& M, bool loaded, DyckResultCache* resultCache);
+
+	/// Compute region_funcs from the functions of -dyckaa-region, i.e. the functions
+	/// whose values they use, e.g. the functions they call, recursively, and the
+	/// constants on the boundary of the region.
+	void computeRegion(Module& M);
+
+	/// Collect the values of the region that the functions out of it may bind to
+	/// other values, from the call graph before it is released.
+	void collectRegionSeeds();
+
+	/// Build region_stable when the graph of the region is compacted.
+	void indexRegionStability();
+
+	/// Return true if the result of v is the same as the one of the whole analysis.
+	bool isSolved(const Value* v) const;
+
+	/// Build region_rest and region_mem_allocas when the graph of the region is compacted.
+	void indexRegionRest(Module& M);
+
+	/// Get all the equivalent sets, and region_rest with -dyckaa-region, i.e. the
+	/// conservative answer of the queries that escape a value.
+	void getAllSets(std::vector<const set<Value*>*>* ret);
+
+	/// Build mem_alloca_reps and csr_mem_allocas when the analysis is done.
+	void indexMemAllocas();
+
+	/// Collect the allocation sites in the equivalent set.
+	void collectMemAllocas(const set<Value*>* aliases, std::vector<Value*>& objects);
+
 	/// Three kinds of information will be printed.
 	/// 1. Alias Sets will be printed to the console
 	/// 2. The relation of Alias Sets will be output into "alias_rel.dot"
@@ -144,11 +218,34 @@ private:
 	///     The summary of the evaluation will be printed to the console
 	void printAliasSetInformation(Module& M);
 
+	/// Output the result of alias() for each pair of the pointers in each function
+	/// into "alias_queries.log", one line per pair: the function, the numbers of the
+	/// two pointers in the function and the result. It is followed by one line for
+	/// each pointer with allocation sites: the function, the number of the pointer,
+	/// "allocas" and the names of getDefaultPointstoMemAlloca(), e.g. "1:main 0 allocas p".
+	void printAliasQueries(Module& M);
+
+	/// Collect the roots of getEscapedPointersTo(): the globals visible to other modules,
+	/// and the arguments of the call sites of each function: its common calls and the
+	/// pointer calls whose called values are in its class.
+	void indexEscapeRoots(Module& M);
+
 	void getEscapedPointersTo(set<DyckVertex*>* ret, Function * func); // escaped to 'func'
 	void getEscapedPointersFrom(set<DyckVertex*>* ret, Value * from); // escaped from 'from'
 
+	/// Collect all the vertices reachable from the vertices in the stack.
+	void getReachableVertices(set<DyckVertex*>* ret, stack<DyckVertex*>& workStack);
+
 public:
-	/// Get the vector of the may/must alias set that escape to 'func'
+	/// With -dyckaa-region, alias() returns MayAlias for a value whose result may differ
+	/// from the one of the whole analysis, and the queries below give conservative
+	/// answers for it: all the sets escape, including the values out of the region,
+	/// a pointer points to all the values or all the allocation sites, and a called
+	/// value is an allocator. getEscapedPointersTo() always gives all the sets, since
+	/// its roots are in the whole module.
+
+	/// Get the vector of the may/must alias set that escape to 'func'.
+	/// The sets are computed once for each 'func' from the call sites in the call graph.
 	void getEscapedPointersTo(std::vector<const set<Value*>*>* ret, Function * func);
 
 	/// Get the vector of the may/must alias set that escape from 'from'
@@ -181,6 +278,7 @@ public:
     ///    "_Znwj", "_ZnwjRKSt9nothrow_t",
     ///    "_Znwm", "_ZnwmRKSt9nothrow_t"
     /// }
+    /// and the ones given by -dyckaa-mem-alloca.
     ///
     /// For a pointer that points to a struct or class field, this interface
     /// may return you nothing, because the field may be initialized using
@@ -197,6 +295,7 @@ public:
     ///    "_Znwj", "_ZnwjRKSt9nothrow_t",
     ///    "_Znwm", "_ZnwmRKSt9nothrow_t"
     /// }
+    /// and the ones given by -dyckaa-mem-alloca.
     bool isDefaultMemAllocaFunction(Value* calledValue);
 
 };
@@ -0,0 +1,69 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#ifndef DYCKRESULTCACHE_H
+#define	DYCKRESULTCACHE_H
+
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MD5.h"
+
+#include "DyckGraph/DyckGraph.h"
+#include "DyckCG/DyckCallGraph.h"
+#include "DyckAA/EdgeLabel.h"
+
+#include <string>
+
+using namespace llvm;
+using namespace std;
+
+/// A directory of the snapshots of DyckAliasAnalysis, see DyckSnapshot, which are
+/// keyed by the MD5 of the bitcode of a module and the options that change the result.
+///
+/// The files whose modification times are the oldest are removed when the total size
+/// exceeds the limit, and the time of a file is updated when it is loaded, so the
+/// least recently used ones are removed first. A seed directory, e.g. filled by CI,
+/// is looked up if a snapshot is not in the cache, and it is never changed.
+class DyckResultCache {
+private:
+	string dir;
+	string seed_dir;
+	uint64_t max_bytes;
+
+	/// the file name of the snapshot of the module
+	string key;
+
+	/// true if the snapshot is loaded from the cache rather than the seed directory
+	bool cache_hit;
+
+public:
+	/// The options that change the result have been added to the hasher,
+	/// which is finished here.
+	DyckResultCache(const string& d, const string& seed, uint64_t maxBytes, Module& M, MD5& options);
+
+	/// Return true if the snapshot of the module is found and loaded.
+	bool load(Module& M, DyckGraph* dg, DyckCallGraph* cg, EdgeLabel& labels);
+
+	/// Save the snapshot of the module into the cache and remove the least recently
+	/// used ones if the cache is too large. Return false if it cannot be saved.
+	bool save(Module& M, DyckGraph* dg, DyckCallGraph* cg, EdgeLabel& labels);
+
+	const string& getKey() const {
+		return key;
+	}
+
+	/// Return true if the result should be saved into the cache, i.e. it is not
+	/// loaded from the cache. A result loaded from the seed directory is also
+	/// saved, so that the cache is warmed by the seed.
+	bool needsSaving() const {
+		return !dir.empty() && !cache_hit;
+	}
+
+private:
+	string getPath(const string& d) const;
+
+	void evict();
+};
+
+#endif	/* DYCKRESULTCACHE_H */
@@ -0,0 +1,49 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#ifndef DYCKSNAPSHOT_H
+#define	DYCKSNAPSHOT_H
+
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MD5.h"
+
+#include "DyckGraph/DyckGraph.h"
+#include "DyckCG/DyckCallGraph.h"
+#include "DyckAA/EdgeLabel.h"
+
+using namespace llvm;
+
+/// A binary snapshot of the result of DyckAliasAnalysis, which contains the
+/// equivalent sets, the labeled edges between them, and the common calls and
+/// the resolved pointer calls of the call graph.
+///
+/// Values are identified by the names of global values, by (function number,
+/// argument number) for arguments, by (function number, instruction ordinal) for
+/// instructions, and by the order in which other constants, including unnamed
+/// globals, are first met when the module is walked. So a snapshot can only be
+/// loaded for the module it is saved from, which is checked by the MD5 of the
+/// bitcode of the module.
+///
+/// The file is a header followed by arrays of 32-bit words, so that it is
+/// mapped into memory and read in place.
+class DyckSnapshot {
+public:
+	static const uint32_t Version = 2;
+
+	/// Compute the MD5 of the bitcode of the module.
+	static void hashModule(Module& M, MD5::MD5Result& result);
+
+	/// Save the frozen graph and the call graph to the file, which is replaced
+	/// atomically. Return false if a value cannot be identified, so that a query
+	/// of it after loading would miss its aliases, or the file cannot be written.
+	static bool save(const char* file, Module& M, DyckGraph* dg, DyckCallGraph* cg, EdgeLabel& labels);
+
+	/// Load the graph and the call graph from the file, both of them must be empty.
+	/// Return false if the file cannot be read or it does not match the module,
+	/// and nothing is changed then.
+	static bool load(const char* file, Module& M, DyckGraph* dg, DyckCallGraph* cg, EdgeLabel& labels);
+};
+
+#endif	/* DYCKSNAPSHOT_H */
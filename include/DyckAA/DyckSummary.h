@@ -0,0 +1,52 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#ifndef DYCKSUMMARY_H
+#define	DYCKSUMMARY_H
+
+#include "llvm/IR/Module.h"
+
+#include "DyckGraph/DyckGraph.h"
+#include "DyckCG/DyckCallGraphNode.h"
+#include "DyckAA/EdgeLabel.h"
+
+#include <tuple>
+
+using namespace llvm;
+
+/// A binary summary of what the intra-procedural analysis derives from a function,
+/// i.e. the normalized graph of a worker of AAAnalyzer, what the worker defers to its
+/// owner, and the calls, returns, etc. recorded in the call graph node of the function.
+///
+/// A summary is keyed by a structural hash of the function, which covers the types,
+/// the instructions and their operands, the names of the global values used and the
+/// library models of the functions called. The values are identified by their places
+/// in the function, i.e. argument numbers, instruction ordinals and (instruction
+/// ordinal, operand number) for the others, so a function with the same hash can use
+/// the summary whatever its name is.
+class DyckSummary {
+public:
+	static const uint32_t Version = 1;
+
+	/// Return 0 if the function cannot be summarized, e.g. it uses an unnamed global.
+	/// The options are the ones that change the summary, e.g. -dyckaa-field-limit.
+	static uint64_t hash(Function* F, uint64_t options);
+
+	/// Save the summary of the function with the hash to the file, which is replaced
+	/// atomically. Return false if a value cannot be identified or the file cannot
+	/// be written.
+	static bool save(const char* file, Function* F, uint64_t hash, DyckGraph* dg, DyckCallGraphNode* node,
+			EdgeLabel& labels, const vector<Value*>& constants, const vector<Instruction*>& casts,
+			const vector<std::tuple<Function*, Value*, Value*> >& implicitCalls);
+
+	/// Load the summary of the function into the empty graph, the call graph node and
+	/// the deferred vectors. Return false if the file cannot be read or it is not of
+	/// the function with the hash, and nothing is changed then.
+	static bool load(const char* file, Function* F, uint64_t hash, DyckGraph* dg, DyckCallGraphNode* node,
+			EdgeLabel& labels, vector<Value*>& constants, vector<Instruction*>& casts,
+			vector<std::tuple<Function*, Value*, Value*> >& implicitCalls);
+};
+
+#endif	/* DYCKSUMMARY_H */
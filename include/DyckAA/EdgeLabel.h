@@ -6,68 +6,73 @@
 #ifndef EDGELABEL_H
 #define	EDGELABEL_H
 
-#include <stdio.h>
-#include <map>
+#include <stdint.h>
+#include <mutex>
 #include <string>
+#include <vector>
 
+/// Edge labels of the dyck graph are 32-bit ids, which are passed to
+/// DyckGraph as void*. The top two bits are the kind of the label, so that
+/// the kind can be checked without a memory access, and an id is never 0.
+/// The deref label has the smallest id, so it is the first entry in the edges
+/// of a vertex, where DyckVertex::getOutVertex() finds it without a search.
+/// The other bits keep the offset or the field index in two's complement.
+///
+/// A value that does not fit in the low bits is interned in a table, and the
+/// id keeps its position in the table with the overflow bit set.
 class EdgeLabel {
 public:
-    enum LABEL_TY {DEREF_TYPE, OFFSET_TYPE, INDEX_TYPE};
+	enum LABEL_TY {
+		DEREF_TYPE = 1, OFFSET_TYPE = 2, INDEX_TYPE = 3
+	};
+
 private:
-    std::string desc;
-public:
-    virtual std::string& getEdgeLabelDescription() { return desc; }
-    virtual bool isLabelTy(LABEL_TY type){ return false; }
-    virtual ~EdgeLabel(){}
-};
+	static const unsigned KindShift = 30;
+	static const uint32_t OverflowBit = 1u << 29;
+	static const uint32_t ValueMask = OverflowBit - 1;
 
-class DerefEdgeLabel : public EdgeLabel {
-public:
-    DerefEdgeLabel() {
-        std::string& desc = EdgeLabel::getEdgeLabelDescription();
-        desc.clear();
-        desc.append("D");
-    }
-    virtual bool isLabelTy(LABEL_TY type) { return type == EdgeLabel::DEREF_TYPE;}
-};
+	static const long MaxInlineValue = (long) (ValueMask >> 1);
+	static const long MinInlineValue = -MaxInlineValue - 1;
 
-class PointerOffsetEdgeLabel : public EdgeLabel {
-private:
-    long offset_bytes;
-public:
-    PointerOffsetEdgeLabel(long bytes) : offset_bytes(bytes){
-        std::string& desc = EdgeLabel::getEdgeLabelDescription();
-        desc.clear();
-        desc.append("@");
-        
-        char temp[1024];
-        sprintf(temp, "%ld", bytes);
-        desc.append(temp);
-    }
-
-    long getOffsetBytes() { return offset_bytes; }
-    
-    virtual bool isLabelTy(LABEL_TY type) { return type == EdgeLabel::OFFSET_TYPE;}
-};
+	/// values that do not fit in the low bits, which are accessed under the mutex
+	/// because labels are created and read by the threads of the intra-procedural analysis
+	std::vector<long> overflow_values;
+	mutable std::mutex overflow_mutex;
+
+	static uint32_t getId(void* label) {
+		return (uint32_t) (uintptr_t) label;
+	}
 
-class FieldIndexEdgeLabel : public EdgeLabel {
-private:
-    long field_index;
 public:
-    FieldIndexEdgeLabel(long idx) : field_index(idx){
-        std::string& desc = EdgeLabel::getEdgeLabelDescription();
-        desc.clear();
-        desc.append("#");
-        
-        char temp[1024];
-        sprintf(temp, "%ld", idx);
-        desc.append(temp);
-    }
-
-    long getFieldIndex() { return field_index; }
-    
-    virtual bool isLabelTy(LABEL_TY type) { return type == EdgeLabel::INDEX_TYPE;}
+	static void* getDerefLabel() {
+		return (void*) (uintptr_t) ((uint32_t) DEREF_TYPE << KindShift);
+	}
+
+	void* getOrInsertOffsetLabel(long bytes) {
+		return getOrInsertLabel(OFFSET_TYPE, bytes);
+	}
+
+	void* getOrInsertIndexLabel(long idx) {
+		return getOrInsertLabel(INDEX_TYPE, idx);
+	}
+
+	/// The value is ignored if the type is DEREF_TYPE.
+	void* getOrInsertLabel(LABEL_TY type, long value);
+
+	static bool isLabelTy(void* label, LABEL_TY type) {
+		return (getId(label) >> KindShift) == (uint32_t) type;
+	}
+
+	static LABEL_TY getLabelTy(void* label) {
+		return (LABEL_TY) (getId(label) >> KindShift);
+	}
+
+	/// Get the offset bytes or the field index of the label.
+	long getValue(void* label) const;
+
+	/// Get the description of the label, e.g. "D", "@8" and "#1",
+	/// which is only used to print the graph.
+	std::string getDescription(void* label) const;
 };
 
 #endif	/* EDGELABEL_H */
-
@@ -0,0 +1,103 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#ifndef DYCKARENA_H
+#define	DYCKARENA_H
+
+#include <stdlib.h>
+#include <mutex>
+#include <vector>
+
+/// The memory pool of the edge storage of a DyckGraph.
+///
+/// Memory is carved from big slabs. A released block is put into the free
+/// list of its size class, i.e. its size rounded up to a power of two, and
+/// is reused by the next allocation of the same class. Nothing is returned
+/// to the system until the arena is destroyed, when all the slabs are freed
+/// at once.
+class DyckArena {
+private:
+	static const unsigned MinClass = 4; // 16 bytes
+	static const unsigned NumClasses = 28;
+	static const unsigned long SlabSize = 256 * 1024;
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	FreeBlock* free_lists[NumClasses];
+
+	std::vector<char*> slabs;
+	char* cur;
+	char* end;
+
+	/// bytes allocated from the system
+	unsigned long reserved;
+
+	/// If it is true, allocations are serialized by the mutex.
+	bool concurrent;
+	std::mutex mutex;
+
+	void* allocateImpl(unsigned long bytes);
+	void deallocateImpl(void* p, unsigned long bytes);
+
+	static unsigned sizeClass(unsigned long bytes);
+
+public:
+	DyckArena();
+	~DyckArena();
+
+	DyckArena(const DyckArena&) = delete;
+	DyckArena& operator=(const DyckArena&) = delete;
+
+	/// Allocate a block of at least bytes.
+	void* allocate(unsigned long bytes) {
+		if (concurrent) {
+			std::lock_guard<std::mutex> guard(mutex);
+			return allocateImpl(bytes);
+		}
+		return allocateImpl(bytes);
+	}
+
+	/// Put a block back to its free list, bytes must be the same as the one
+	/// used to allocate it.
+	void deallocate(void* p, unsigned long bytes) {
+		if (concurrent) {
+			std::lock_guard<std::mutex> guard(mutex);
+			deallocateImpl(p, bytes);
+		} else {
+			deallocateImpl(p, bytes);
+		}
+	}
+
+	/// Exchange the memory of the two arenas. The blocks allocated from one
+	/// arena are owned by the other one after that.
+	void swap(DyckArena& other);
+
+	/// Set it to true before the arena is used by multiple threads.
+	void setConcurrent(bool c) {
+		concurrent = c;
+	}
+
+	/// Bytes allocated from the system.
+	unsigned long getMemoryUsage() const {
+		return reserved;
+	}
+
+	/// If arena is NULL, the block is allocated via malloc.
+	static void* allocate(DyckArena* arena, unsigned long bytes) {
+		return arena ? arena->allocate(bytes) : malloc(bytes);
+	}
+
+	/// If arena is NULL, the block is released via free.
+	static void deallocate(DyckArena* arena, void* p, unsigned long bytes) {
+		if (arena)
+			arena->deallocate(p, bytes);
+		else
+			free(p);
+	}
+};
+
+#endif	/* DYCKARENA_H */
@@ -7,26 +7,189 @@
 #define	DYCKHALFGRAPH_H
 
 #include "DyckVertex.h"
+#include "DyckWorkList.h"
+#include <atomic>
+#include <memory>
 #include <unordered_map>
 #include <stack>
+#include <vector>
 
 using namespace std;
 
+/// A read-only copy of the edges among the representatives of a DyckGraph
+/// in the compressed sparse row (CSR) format. Vertices and labels are numbered
+/// densely, so that traversals do not need to chase the pointers of sets.
+///
+/// It is built by DyckGraph::freeze(), and vertices that are created after that
+/// have no CSR id. DyckGraph::compact() renumbers the vertices and drops the in edges.
+class DyckCSR {
+public:
+	static const unsigned InvalidId = ~0u;
+
+private:
+	friend class DyckGraph;
+
+	/// csr id -> vertex
+	vector<DyckVertex*> id_ver_vec;
+	/// vertex index -> csr id
+	vector<unsigned> index_id_vec;
+
+	/// the out edges of vertex i are in [out_offsets[i], out_offsets[i+1])
+	vector<unsigned> out_offsets;
+	vector<unsigned> out_labels;
+	vector<unsigned> out_targets;
+
+	/// the in edges of vertex i are in [in_offsets[i], in_offsets[i+1])
+	vector<unsigned> in_offsets;
+	vector<unsigned> in_labels;
+	vector<unsigned> in_sources;
+
+public:
+	unsigned numVertices() const {
+		return id_ver_vec.size();
+	}
+
+	unsigned numEdges() const {
+		return out_targets.size();
+	}
+
+	DyckVertex* getVertex(unsigned id) const {
+		return id_ver_vec[id];
+	}
+
+	/// Return InvalidId if the vertex is not a representative when the graph is frozen.
+	unsigned getId(DyckVertex* v) const {
+		unsigned idx = v->getIndex();
+		return idx < index_id_vec.size() ? index_id_vec[idx] : InvalidId;
+	}
+
+	/// Out edges of a vertex are sorted by (label id, target id).
+	/// @{
+	unsigned outBegin(unsigned id) const {
+		return out_offsets[id];
+	}
+
+	unsigned outEnd(unsigned id) const {
+		return out_offsets[id + 1];
+	}
+
+	unsigned outLabel(unsigned edge) const {
+		return out_labels[edge];
+	}
+
+	unsigned outTarget(unsigned edge) const {
+		return out_targets[edge];
+	}
+	/// @}
+
+	/// In edges of a vertex are sorted by (label id, source id).
+	/// @{
+	unsigned inBegin(unsigned id) const {
+		return in_offsets[id];
+	}
+
+	unsigned inEnd(unsigned id) const {
+		return in_offsets[id + 1];
+	}
+
+	unsigned inLabel(unsigned edge) const {
+		return in_labels[edge];
+	}
+
+	unsigned inSource(unsigned edge) const {
+		return in_sources[edge];
+	}
+	/// @}
+
+	/// Approximate memory used by the CSR.
+	unsigned long getMemoryUsage() const;
+};
+
 /// This class models a dyck-cfl language as a graph, which does not contain the barred edges.
 /// See details in http://dl.acm.org/citation.cfm?id=2491956.2462159&coll=DL&dl=ACM&CFID=379446910&CFTOKEN=65130716 .
 class DyckGraph {
 private:
-	set<DyckVertex*> vertices;
+	/// vertex index -> the vertex, which is NULL once it is combined into another one
+	vector<DyckVertex*> vertices;
+	/// the number of the vertices that are not NULL
+	unsigned num_reps;
+
+	/// value -> index of the vertex created for the value.
+	/// It is never updated when vertices are combined; the
+	/// representative is found via the union-find below.
+	unordered_map<void *, unsigned> val_ver_map;
+
+	/// the index of the next vertex
+	unsigned next_index;
+
+	/// Vertices are placed in slabs by their indices, and the slot of a vertex is
+	/// never reused after it is combined into another one, nor is the vertex destroyed,
+	/// so that its index stays readable. The edges are allocated from the arena.
+	/// All of them are released at once when the graph is destroyed.
+	/// @{
+	static const unsigned VerticesPerSlab = 1024;
+	vector<DyckVertex*> ver_slabs;
+	DyckArena arena;
+	/// @}
+
+	/// The union-find of vertex indices, using path compression
+	/// and union-by-rank. A root index is mapped to the vertex that
+	/// represents its set in uf_rep_vec.
+	/// @{
+	vector<unsigned> uf_parent_vec;
+	vector<unsigned char> uf_rank_vec;
+	vector<DyckVertex*> uf_rep_vec;
+	/// @}
+
+	/// dense label ids
+	/// @{
+	vector<void*> id_label_vec;
+	unordered_map<void*, unsigned> label_id_map;
+	/// @}
+
+	DyckCSR* csr;
+
+	/// The (vertex, label) pairs that may have more than one target. A pair is
+	/// added when an edge is added or vertices are combined, so that
+	/// qirunAlgorithm() does not need to scan the whole graph.
+	DyckWorkList pending;
+
+	/// the number of threads used by qirunAlgorithm()
+	unsigned num_threads;
+	/// a round of parallelQirunAlgorithm() with fewer pairs to merge is done sequentially
+	unsigned min_parallel_obligations;
+
+	/// The concurrent union-find, the marks of the affected vertices and the new reps
+	/// of parallelQirunAlgorithm() by vertex indices. They are kept across the calls
+	/// and grown with the graph, and a round only resets the entries it touches.
+	/// @{
+	unique_ptr<atomic<unsigned>[]> par_parent;
+	unique_ptr<atomic<bool>[]> par_affected;
+	unsigned par_capacity;
+	vector<DyckVertex*> par_new_rep_vec;
+	/// @}
+
+	/// set by compact()
+	bool compacted;
+
+	/// the number of vertices combined into others, and the number of edges moved by that
+	/// @{
+	unsigned long num_merges;
+	unsigned long num_edges_moved;
+	/// @}
+
+	/// (the index of the rep, the index of the vertex combined into it) of each merge
+	/// since the last takeMerges(), which is recorded only if track_merges is set
+	/// @{
+	bool track_merges;
+	vector<pair<unsigned, unsigned> > merge_log;
+	/// @}
 
-	unordered_map<void *, DyckVertex*> val_ver_map;
 public:
-	DyckGraph() {
-	}
-	~DyckGraph() {
-		for (auto& v : vertices) {
-			delete v;
-		}
+	DyckGraph() : num_reps(0), next_index(0), csr(NULL), num_threads(1), min_parallel_obligations(1024), par_capacity(0), compacted(false),
+			num_merges(0), num_edges_moved(0), track_merges(false) {
 	}
+	~DyckGraph();
 
 	/// The number of vertices in the graph.
 	unsigned int numVertices();
@@ -35,12 +198,23 @@ public:
 	/// Please use it after you call void qirunAlgorithm().
 	unsigned int numEquivalentClasses();
 
-	/// Get the set of vertices in the graph.
-	set<DyckVertex*>& getVertices();
+	/// Get the vertices in the graph by their indices, i.e. in the order of
+	/// their creation. The vertex of an index is NULL once it is combined into
+	/// another one.
+	const vector<DyckVertex*>& getVertices() {
+		return vertices;
+	}
+
+	/// Return true if the vertex has not been combined into another one.
+	/// A combined vertex is kept until the graph is destroyed, so it can be
+	/// given after it is combined.
+	bool containsVertex(DyckVertex* v) {
+		return vertices[v->getIndex()] == v;
+	}
 
-	/// You are not recommended to use the function when the graph is big,
-	/// because it is time-consuming.
-	void printAsDot(const char * filename) const;
+	/// Print the representatives and the edges among them as a dot file.
+	/// The graph is frozen if it is not. See DyckGraphExporter for other formats.
+	void printAsDot(const char * filename);
 
 	/// Combine x's rep and y's rep.
 	DyckVertex* combine(DyckVertex* x, DyckVertex* y);
@@ -56,17 +230,148 @@ public:
 	/// The algorithm proposed by Qirun Zhang.
 	/// Find the paper here: http://dl.acm.org/citation.cfm?id=2491956.2462159&coll=DL&dl=ACM&CFID=379446910&CFTOKEN=65130716 .
 	/// Note that if there are two edges with the same label: a->b and a->c, b and c will be put into the same equivelant class.
+	/// Only the pairs changed since the last call are visited.
 	/// If the function does nothing, return true, otherwise return false.
 	bool qirunAlgorithm();
 
+	/// Use multiple threads in qirunAlgorithm() if threads > 1. The equivalent sets
+	/// are the same as the ones computed sequentially. When fewer than minObligations
+	/// pairs of vertices are to be merged, the rest is done sequentially.
+	void setNumThreads(unsigned threads, unsigned minObligations = 1024) {
+		num_threads = threads ? threads : 1;
+		min_parallel_obligations = minObligations;
+	}
+
+	/// Set the order in which qirunAlgorithm() merges the pairs, FIFO by default.
+	/// It only changes the representatives and the cost, not the equivalent sets.
+	/// Labels are compared by their values in DyckWorkList::LABEL_PRIORITY.
+	void setMergeOrder(DyckWorkList::Order order) {
+		pending.setOrder(order);
+	}
+
+	/// The number of vertices combined into others by combine() and qirunAlgorithm().
+	unsigned long getNumMerges() {
+		return num_merges;
+	}
+
+	/// The number of edges moved from the vertices combined into others.
+	unsigned long getNumEdgesMoved() {
+		return num_edges_moved;
+	}
+
+	/// Record the merges done by combine() and qirunAlgorithm(), so that a client
+	/// can tell which equivalent sets are changed. The log is dropped when it is disabled.
+	void setTrackMerges(bool track) {
+		track_merges = track;
+		if (!track) {
+			vector<pair<unsigned, unsigned> >().swap(merge_log);
+		}
+	}
+
+	/// Move the merges recorded since the last call into merges in the order they are
+	/// done. Each of them is (the index of the rep, the index of the vertex combined
+	/// into it), and the latter is no longer a rep.
+	void takeMerges(vector<pair<unsigned, unsigned> >& merges) {
+		merges.clear();
+		merges.swap(merge_log);
+	}
+
+	/// Get the dense id of a label, a new id is assigned if the label is new.
+	unsigned getLabelId(void* label);
+
+	/// Get the label of a dense label id.
+	void* getLabel(unsigned id) {
+		return id_label_vec[id];
+	}
+
+	/// The number of dense label ids.
+	unsigned numLabels() {
+		return id_label_vec.size();
+	}
+
+	/// Build the CSR of the graph, where the reps are numbered in the order of their
+	/// creation. Please use it after you call qirunAlgorithm().
+	/// The CSR is dropped once the graph is changed by combine() or qirunAlgorithm(),
+	/// and edges added via DyckVertex::addTarget after freezing are not in it.
+	void freeze();
+
+	/// Return the CSR if the graph is frozen, otherwise return NULL.
+	DyckCSR* getCSR() {
+		return csr;
+	}
+
+	/// Prepare the graph for queries when the analysis is done. The sources of the
+	/// vertices, the in edges of the CSR and the names are dropped, and the CSR
+	/// is renumbered in reverse Cuthill-McKee order. The targets and the equivalent
+	/// sets are copied into a new arena in the same order, so that traversals touch
+	/// nearby memory, and the old arena is released.
+	///
+	/// After that, the graph cannot be changed, but vertices without edges can still
+	/// be retrieved.
+	void compact();
+
+	bool isCompacted() {
+		return compacted;
+	}
+
+	/// Approximate memory used by the graph.
+	unsigned long getMemoryUsage();
+
+	/// Print the number of vertices, edges and the memory usage.
+	void printMemoryUsage();
+
 	/// validation
 	void validation(const char*, int);
 
 private:
-	void removeFromWorkList(multimap<DyckVertex*, void*>& list, DyckVertex* v, void* l);
+	friend class DyckVertex;
+
+	/// Create a vertex with a new index.
+	DyckVertex* newDyckVertex(void* value, const char* name);
+
+	/// Get the vertex of an index, which may have been combined into another one.
+	DyckVertex* vertexAt(unsigned index) {
+		return ver_slabs[index / VerticesPerSlab] + index % VerticesPerSlab;
+	}
+
+	/// Rebuild the CSR with the vertex of old id order[i] as the i-th one,
+	/// and without the in edges.
+	void renumberCSR(const vector<unsigned>& order);
+
+	/// Remove a vertex that has been combined into another one from the vertices.
+	void deleteDyckVertex(DyckVertex* v);
 
-	bool containsInWorkList(multimap<DyckVertex*, void*>& list, DyckVertex* v, void* l);
+	/// Find the root index of the set that contains the index.
+	unsigned findRoot(unsigned index);
+
+	/// Union the sets of x and y, and x becomes the representative.
+	void unionVertices(DyckVertex* x, DyckVertex* y);
+
+	/// Move all the edges of y to x, and y will be removed.
+	void mergeVertices(DyckVertex* x, DyckVertex* y);
+
+	/// Return true if the vertex of the index has not been combined into another one.
+	bool isAlive(unsigned index) {
+		return uf_rep_vec[findRoot(index)] == vertexAt(index);
+	}
+
+	void thaw();
+
+	/// Merge the pending pairs until every (vertex, label) has at most
+	/// one target. Return true if nothing is merged.
+	bool normalize();
+
+	/// The round-based version of qirunAlgorithm(). In each round, all the pairs
+	/// of vertices that must be merged are found and unioned by the threads, and
+	/// then the edges of the merged vertices are redirected to their reps.
+	bool parallelQirunAlgorithm();
+
+	/// Make the arrays of parallelQirunAlgorithm() cover all the vertex indices.
+	void growParallelArrays();
+
+	void removeFromWorkList(DyckVertex* v, void* l);
+
+	void addToWorkList(DyckVertex* v, void* l);
 };
 
 #endif	/* DYCKHALFGRAPH_H */
-
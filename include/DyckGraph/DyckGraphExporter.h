@@ -0,0 +1,86 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#ifndef DYCKGRAPHEXPORTER_H
+#define	DYCKGRAPHEXPORTER_H
+
+#include "DyckGraph.h"
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/// Writes the representatives of a DyckGraph and the edges among them into a file
+/// in a single pass over the CSR of the graph.
+///
+/// A representative is numbered by its CSR id plus one. The text of a vertex or an
+/// edge is formatted into a buffer and the buffer is written once per block of
+/// vertices; the vertices of a block are formatted by several threads if
+/// setNumThreads() is used, and the output is the same as the sequential one.
+class DyckGraphExporter {
+public:
+	enum Format {
+		/// graphviz
+		DOT,
+		/// a binary list of (source, label, target) triples, see write()
+		EDGE_LIST,
+		/// GraphML
+		GRAPHML
+	};
+
+	static const uint32_t EdgeListMagic = 0x4b435944; // "DYCK"
+	static const uint32_t EdgeListVersion = 1;
+
+private:
+	DyckGraph* graph;
+	DyckCSR* csr;
+
+	/// label id -> description
+	vector<string> label_descs;
+
+	/// csr id -> whether the vertex is highlighted
+	vector<bool> highlighted;
+
+	unsigned num_threads;
+
+public:
+	/// The graph is frozen if it is not.
+	DyckGraphExporter(DyckGraph* dg);
+
+	/// Set how a label is printed, and the value of the label is printed by default.
+	void setLabelDescription(function<string(void*)> desc);
+
+	/// Highlight the vertices and the edges between them, which are red in dot
+	/// files, and they are marked in the other formats.
+	void setHighlighted(const set<DyckVertex*>& vers);
+
+	void setNumThreads(unsigned threads) {
+		num_threads = threads ? threads : 1;
+	}
+
+	/// Return false if the file cannot be written.
+	///
+	/// An edge list is a sequence of 32-bit words: the magic, the version, the
+	/// number of vertices, labels, highlighted vertices and edges; then the length
+	/// and the bytes of each label description, padded to 4 bytes; then the ids of
+	/// the highlighted vertices; and (source, label id, target) for each edge.
+	/// Vertices are numbered from 0 in the edge list.
+	bool write(const char* file, Format format);
+
+private:
+	/// Format the vertices in [begin, end).
+	void formatVertices(string& buf, unsigned begin, unsigned end, Format format);
+
+	/// Format the out edges of the vertices in [begin, end).
+	void formatEdges(string& buf, unsigned begin, unsigned end, Format format);
+
+	void formatHeader(string& buf, Format format);
+
+	void formatFooter(string& buf, Format format);
+};
+
+#endif	/* DYCKGRAPHEXPORTER_H */
@@ -0,0 +1,83 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#ifndef DYCKREACHABILITY_H
+#define	DYCKREACHABILITY_H
+
+#include "DyckGraph.h"
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/// Reachability among the vertices of a DyckCSR via the edges of some labels,
+/// e.g. the offset edges for partial aliases.
+///
+/// The strongly connected components of the subgraph are condensed, and each
+/// component gets an interval [low, post] from a post-order DFS of the condensed
+/// graph. A component can only reach the components whose intervals are in its
+/// own, and if every component has at most one predecessor, it reaches all of them.
+/// Other queries are answered by a DFS that skips the components whose intervals
+/// do not contain the target, and the answers are cached.
+class DyckReachability {
+private:
+	DyckCSR* csr;
+
+	/// csr id -> component
+	vector<unsigned> comp_vec;
+
+	/// the edges among the components, in the same layout as DyckCSR
+	/// @{
+	vector<unsigned> comp_offsets;
+	vector<unsigned> comp_targets;
+	/// @}
+
+	/// the intervals of the components
+	/// @{
+	vector<unsigned> low_vec;
+	vector<unsigned> post_vec;
+	/// @}
+
+	/// true if no component has more than one predecessor
+	bool forest;
+
+	/// (from component, to component) -> reachable, for the queries not decided by the intervals
+	unordered_map<uint64_t, bool> cache;
+
+	/// the components visited by the DFS of the current query are marked with visit_stamp
+	/// @{
+	vector<unsigned> visit_marks;
+	unsigned visit_stamp;
+	/// @}
+
+public:
+	/// Only the edges whose label ids are set in labels are considered.
+	DyckReachability(DyckCSR* c, const vector<bool>& labels);
+
+	DyckCSR* getCSR() {
+		return csr;
+	}
+
+	unsigned numComponents() const {
+		return low_vec.size();
+	}
+
+	/// Return true if there is a path from the vertex of csr id from to the vertex
+	/// of csr id to. The two vertices must be different.
+	bool reachable(unsigned from, unsigned to);
+
+private:
+	/// Tarjan's algorithm, components are numbered in reverse topological order.
+	void condense(const vector<bool>& labels);
+
+	void computeIntervals();
+
+	bool contains(unsigned comp, unsigned inner) const {
+		return low_vec[comp] <= low_vec[inner] && post_vec[inner] <= post_vec[comp];
+	}
+};
+
+#endif	/* DYCKREACHABILITY_H */
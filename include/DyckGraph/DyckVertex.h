@@ -11,6 +11,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "DyckVertexSet.h"
+
 using namespace std;
 
 class DyckGraph;
@@ -18,29 +20,41 @@ class DyckGraph;
 
 class DyckVertex {
 private:
-	static int global_indx;
-	int index;
+	DyckGraph* graph;
+	unsigned index;
 	const char * name;
 
-	set<void*> in_lables;
-	set<void*> out_lables;
-
-	map<void*, set<DyckVertex*>> in_vers;
-	map<void*, set<DyckVertex*>> out_vers;
-
-	/// only store non-null value
-	set<void*> equivclass;
+	DyckEdgeMap in_vers;
+	DyckEdgeMap out_vers;
+
+	/// The non-null values in the equivalent set, kept as a linked list
+	/// allocated from the arena, so that two sets are spliced in O(1).
+	/// @{
+	struct EquivNode {
+		void* value;
+		EquivNode* next;
+	};
+	EquivNode* equiv_head;
+	EquivNode* equiv_tail;
+	unsigned equiv_size;
+	/// @}
+
+	/// The sorted view of the equivalent set, which is built on demand
+	/// and dropped when the set is changed.
+	set<void*>* equiv_cache;
 
 	/// Default constructor is not visible.
 	/// please use DyckGraph::retrieveDyckVertex for initialization
 	DyckVertex();
 
 	/// The constructor is not visible. The first argument is the pointer of the value that you want to encapsulate.
-	/// The second argument is the name of the vertex, which will be used in void DyckGraph::printAsDot() function.
+	/// The second argument is the dense index assigned by the graph.
+	/// The third argument is the graph, from whose arena the edges are allocated.
+	/// The fourth argument is the name of the vertex, which will be used in void DyckGraph::printAsDot() function.
 	/// You are not recommended to assign names to vertices when you need not to print the graph,
 	/// because it may be time-consuming for you to construct names for vertices.
 	/// please use DyckGraph::retrieveDyckVertex for initialization.
-	DyckVertex(void * v, const char* itsname = NULL);
+	DyckVertex(void * v, unsigned idx, DyckGraph* g, const char* itsname = NULL);
 
 public:
 	friend class DyckGraph;
@@ -49,17 +63,25 @@ public:
 	~DyckVertex();
 
 	/// Get its index
-	/// The index of the first vertex you create is 0, the second one is 1, ...
-	int getIndex();
+	/// The index of the first vertex you create in a graph is 0, the second one is 1, ...
+	unsigned getIndex();
 
 	/// Get its name
 	const char * getName();
 
 	/// Get the source vertices corresponding the label
-	set<DyckVertex*>* getInVertices(void * label);
+	DyckVertexSet* getInVertices(void * label);
 
 	/// Get the target vertices corresponding the label
-	set<DyckVertex*>* getOutVertices(void * label);
+	DyckVertexSet* getOutVertices(void * label);
+
+	/// Get the target corresponding the label, or NULL if there is no such target.
+	/// After DyckGraph::qirunAlgorithm(), a vertex has at most one target per label,
+	/// otherwise the first one of them is returned. It takes no search for the smallest
+	/// label of the vertex.
+	DyckVertex* getOutVertex(void* label) {
+		return out_vers.front(label);
+	}
 
 	/// Get the number of vertices that are the targets of this vertex, and have the edge label: label.
 	unsigned int outNumVertices(void* label);
@@ -70,21 +92,19 @@ public:
 	/// Total degree of the vertex
 	unsigned int degree();
 
-	/// Get all the labels in the edges that point to the vertex's targets.
-	set<void*>& getOutLabels();
-
-	/// Get all the labels in the edges that point to the vertex.
-	set<void*>& getInLabels();
-
 	/// Get all the vertex's targets.
-	/// The return value is a map which maps labels to a set of vertices.
-	map<void*, set<DyckVertex*>>& getOutVertices();
+	/// The return value is a map which maps labels to a set of vertices,
+	/// and its keys are all the labels in the edges that point to the vertex's targets.
+	DyckEdgeMap& getOutVertices();
 
 	/// Get all the vertex's sources.
-	/// The return value is a map which maps labels to a set of vertices.
-	map<void*, set<DyckVertex*>>& getInVertices();
+	/// The return value is a map which maps labels to a set of vertices,
+	/// and its keys are all the labels in the edges that point to the vertex.
+	DyckEdgeMap& getInVertices();
 
 	/// Add a target with a label. Meanwhile, this vertex will be a source of ver.
+	/// If the vertex has more than one target with the label, the graph will
+	/// combine them in the next DyckGraph::qirunAlgorithm().
 	void addTarget(DyckVertex* ver, void* label);
 
 	/// Remove a target. Meanwhile, this vertex will be removed from ver's sources
@@ -100,11 +120,27 @@ public:
 
 	/// Get the equivalent set of non-null value.
 	/// Use it after you call DyckGraph::qirunAlgorithm().
+	/// The returned set is built on demand, and it is invalidated
+	/// when the vertex is combined with another one.
 	set<void*>* getEquivalentSet();
 
+	/// Get the size of the equivalent set without building it.
+	unsigned getEquivalentSetSize();
+
+	/// Approximate memory used by the vertex, including its edges.
+	unsigned long getMemoryUsage();
+
 private:
 	void addSource(DyckVertex* ver, void* label);
 	void removeSource(DyckVertex* ver, void* label);
+
+	/// Forget the memory from the arena, which is only used when the arena
+	/// is about to be destroyed.
+	void abandonArenaMemory();
+
+	/// Drop the sources and the name, and copy the targets and the equivalent set
+	/// into the current arena of the graph, see DyckGraph::compact().
+	void compact();
 };
 
 #endif	/* DYCKVERTEX_H */
@@ -0,0 +1,559 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#ifndef DYCKVERTEXSET_H
+#define	DYCKVERTEXSET_H
+
+#include <algorithm>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <stdint.h>
+#include <utility>
+
+#include "DyckArena.h"
+
+class DyckVertex;
+
+/// A small set of vertices stored as a sorted array.
+/// Up to two vertices are stored inline, which covers almost all the
+/// (vertex, label) pairs in a normalized graph, so that no heap memory
+/// is needed for them. The interfaces follow std::set<DyckVertex*>.
+///
+/// A set of a high-degree vertex, whose capacity exceeds MaxSortedCapacity, is
+/// not sorted. Its array is followed by an open-addressing index from vertices to
+/// their positions in the same block, so that inserting and erasing a vertex do
+/// not move the array, which would make merging along the vertex quadratic.
+///
+/// The set does not know where its spilled array comes from, so the arena
+/// is given when the set grows, and the owner must call release() with the
+/// same arena before the set is destroyed.
+class DyckVertexSet {
+public:
+	typedef DyckVertex* const * iterator;
+	typedef DyckVertex* const * const_iterator;
+
+private:
+	static const unsigned InlineCapacity = 2;
+	static const unsigned MaxSortedCapacity = 64;
+
+	unsigned Size;
+	unsigned Capacity;
+	union {
+		DyckVertex* Inline[InlineCapacity];
+		DyckVertex** Heap;
+	};
+
+	DyckVertex** data() {
+		return Capacity > InlineCapacity ? Heap : Inline;
+	}
+
+	DyckVertex* const * data() const {
+		return Capacity > InlineCapacity ? Heap : Inline;
+	}
+
+	/// Return the position where v is or should be inserted.
+	unsigned lowerBound(DyckVertex* v) const {
+		DyckVertex* const * d = data();
+		unsigned lo = 0, hi = Size;
+		while (lo < hi) {
+			unsigned mid = (lo + hi) / 2;
+			if (d[mid] < v)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	/// The index of an unsorted set
+	/// @{
+	static bool isIndexed(unsigned capacity) {
+		return capacity > MaxSortedCapacity;
+	}
+
+	/// The bytes of the spilled array and its index, which has twice as many slots
+	/// as the array, each holding a position plus one or 0 if it is empty.
+	static size_t blockBytes(unsigned capacity) {
+		return sizeof(DyckVertex*) * capacity + (isIndexed(capacity) ? sizeof(unsigned) * 2 * capacity : 0);
+	}
+
+	unsigned* index() const {
+		return (unsigned*) (Heap + Capacity);
+	}
+
+	unsigned hashSlot(DyckVertex* v) const {
+		return (unsigned) (((uintptr_t) v >> 3) * 2654435761u) & (2 * Capacity - 1);
+	}
+
+	/// Return the slot of v, or the empty slot where v should be put.
+	unsigned findSlot(DyckVertex* v) const {
+		unsigned* idx = index();
+		unsigned slot = hashSlot(v);
+		while (idx[slot] && Heap[idx[slot] - 1] != v)
+			slot = (slot + 1) & (2 * Capacity - 1);
+		return slot;
+	}
+
+	void buildIndex() {
+		unsigned* idx = index();
+		memset(idx, 0, sizeof(unsigned) * 2 * Capacity);
+		for (unsigned i = 0; i < Size; i++)
+			idx[findSlot(Heap[i])] = i + 1;
+	}
+
+	/// Empty the slot and move the following ones of the same probe sequence back.
+	void clearSlot(unsigned slot) {
+		unsigned* idx = index();
+		const unsigned mask = 2 * Capacity - 1;
+		unsigned next = slot;
+		while (true) {
+			next = (next + 1) & mask;
+			if (!idx[next])
+				break;
+			// the entry can be moved back unless its home is cyclically in (slot, next]
+			unsigned home = hashSlot(Heap[idx[next] - 1]);
+			if (((next - home) & mask) >= ((next - slot) & mask)) {
+				idx[slot] = idx[next];
+				slot = next;
+			}
+		}
+		idx[slot] = 0;
+	}
+	/// @}
+
+	void grow(DyckArena* arena) {
+		unsigned newCap = Capacity * 2;
+		if (isIndexed(newCap)) {
+			// the index is masked by the capacity, which may not be a power of two after relocate()
+			newCap = MaxSortedCapacity * 2;
+			while (newCap <= Capacity)
+				newCap *= 2;
+		}
+		DyckVertex** newData = (DyckVertex**) DyckArena::allocate(arena, blockBytes(newCap));
+		memcpy(newData, data(), sizeof(DyckVertex*) * Size);
+		if (Capacity > InlineCapacity)
+			DyckArena::deallocate(arena, Heap, blockBytes(Capacity));
+		Heap = newData;
+		Capacity = newCap;
+		if (isIndexed(Capacity))
+			buildIndex();
+	}
+
+public:
+	DyckVertexSet() :
+			Size(0), Capacity(InlineCapacity) {
+	}
+
+	DyckVertexSet(DyckVertexSet&& other) :
+			Size(other.Size), Capacity(other.Capacity) {
+		memcpy(Inline, other.Inline, sizeof(Inline));
+		other.Size = 0;
+		other.Capacity = InlineCapacity;
+	}
+
+	DyckVertexSet(const DyckVertexSet&) = delete;
+	DyckVertexSet& operator=(const DyckVertexSet&) = delete;
+
+	~DyckVertexSet() {
+		assert(Capacity == InlineCapacity && "The set is not released!");
+	}
+
+	iterator begin() const {
+		return data();
+	}
+
+	iterator end() const {
+		return data() + Size;
+	}
+
+	unsigned size() const {
+		return Size;
+	}
+
+	bool empty() const {
+		return Size == 0;
+	}
+
+	unsigned count(DyckVertex* v) const {
+		if (isIndexed(Capacity))
+			return index()[findSlot(v)] != 0;
+
+		unsigned pos = lowerBound(v);
+		return pos < Size && data()[pos] == v;
+	}
+
+	/// Return true if v is newly inserted.
+	bool insert(DyckVertex* v, DyckArena* arena) {
+		if (isIndexed(Capacity)) {
+			unsigned slot = findSlot(v);
+			if (index()[slot])
+				return false;
+
+			if (Size == Capacity) {
+				grow(arena);
+				slot = findSlot(v);
+			}
+			Heap[Size] = v;
+			index()[slot] = ++Size;
+			return true;
+		}
+
+		unsigned pos = lowerBound(v);
+		if (pos < Size && data()[pos] == v)
+			return false;
+
+		if (Size == Capacity) {
+			grow(arena);
+			if (isIndexed(Capacity)) {
+				Heap[Size] = v;
+				index()[findSlot(v)] = ++Size;
+				return true;
+			}
+		}
+
+		DyckVertex** d = data();
+		memmove(d + pos + 1, d + pos, sizeof(DyckVertex*) * (Size - pos));
+		d[pos] = v;
+		Size++;
+		return true;
+	}
+
+	/// Return the number of removed vertices, i.e. 0 or 1.
+	unsigned erase(DyckVertex* v) {
+		if (isIndexed(Capacity)) {
+			unsigned slot = findSlot(v);
+			unsigned pos = index()[slot];
+			if (!pos)
+				return 0;
+
+			// the last vertex takes the position of v
+			clearSlot(slot);
+			if (pos != Size) {
+				DyckVertex* last = Heap[Size - 1];
+				index()[findSlot(last)] = pos;
+				Heap[pos - 1] = last;
+			}
+			Size--;
+			return 1;
+		}
+
+		unsigned pos = lowerBound(v);
+		if (pos >= Size || data()[pos] != v)
+			return 0;
+
+		DyckVertex** d = data();
+		memmove(d + pos, d + pos + 1, sizeof(DyckVertex*) * (Size - pos - 1));
+		Size--;
+		return 1;
+	}
+
+	/// Replace each vertex v with f(v). The set may shrink but never grows,
+	/// so that no memory is allocated.
+	template<class F>
+	void remap(F f) {
+		DyckVertex** d = data();
+		for (unsigned i = 0; i < Size; i++)
+			d[i] = f(d[i]);
+		std::sort(d, d + Size);
+		Size = std::unique(d, d + Size) - d;
+		if (isIndexed(Capacity))
+			buildIndex();
+	}
+
+	/// Copy the spilled array to a block of the exact size from the arena, or to
+	/// the inline storage if it fits. The old array is not given back, which is
+	/// only used when its arena is about to be destroyed.
+	void relocate(DyckArena* arena) {
+		if (Capacity <= InlineCapacity)
+			return;
+
+		DyckVertex** old = Heap;
+		if (Size <= InlineCapacity) {
+			memcpy(Inline, old, sizeof(DyckVertex*) * Size);
+			Capacity = InlineCapacity;
+		} else if (isIndexed(Capacity)) {
+			// the index depends on the capacity, which is kept
+			Heap = (DyckVertex**) DyckArena::allocate(arena, blockBytes(Capacity));
+			memcpy(Heap, old, blockBytes(Capacity));
+		} else {
+			Heap = (DyckVertex**) DyckArena::allocate(arena, sizeof(DyckVertex*) * Size);
+			memcpy(Heap, old, sizeof(DyckVertex*) * Size);
+			Capacity = Size;
+		}
+	}
+
+	/// Remove all the vertices and give the spilled array back to the arena.
+	void release(DyckArena* arena) {
+		if (Capacity > InlineCapacity)
+			DyckArena::deallocate(arena, Heap, blockBytes(Capacity));
+		Size = 0;
+		Capacity = InlineCapacity;
+	}
+
+	/// Heap memory used by the set, not including the set itself.
+	unsigned long heapBytes() const {
+		return Capacity > InlineCapacity ? blockBytes(Capacity) : 0;
+	}
+};
+
+/// The edges of a vertex, which map labels to the sets of adjacent vertices.
+/// Entries are sorted by labels, the first one is stored inline and the others
+/// are spilled to the heap. Entries with empty sets are never kept, so that
+/// iterating the map is the same as iterating the labels of the vertex.
+/// The interfaces follow std::map<void*, DyckVertexSet>.
+///
+/// The spilled entries and the sets are allocated from the arena of the map,
+/// or via malloc if the arena is NULL.
+class DyckEdgeMap {
+public:
+	struct Entry {
+		void* first;
+		DyckVertexSet second;
+
+		Entry(void* label) :
+				first(label) {
+		}
+
+	};
+
+	typedef Entry* iterator;
+	typedef const Entry* const_iterator;
+
+private:
+	static const unsigned InlineCapacity = 1;
+
+	DyckArena* Arena;
+	unsigned Size;
+	unsigned Capacity;
+	union {
+		char Inline[sizeof(Entry) * InlineCapacity];
+		Entry* Heap;
+		void* Align;
+	};
+
+	Entry* data() {
+		return Capacity > InlineCapacity ? Heap : (Entry*) Inline;
+	}
+
+	const Entry* data() const {
+		return Capacity > InlineCapacity ? Heap : (const Entry*) Inline;
+	}
+
+	unsigned lowerBound(void* label) const {
+		const Entry* d = data();
+		unsigned lo = 0, hi = Size;
+		while (lo < hi) {
+			unsigned mid = (lo + hi) / 2;
+			if (d[mid].first < label)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	// DyckVertexSet does not point to itself, so entries can be relocated
+	// by memory copy without calling constructors and destructors.
+	void grow() {
+		unsigned newCap = Capacity * 2;
+		Entry* newData = (Entry*) DyckArena::allocate(Arena, sizeof(Entry) * newCap);
+		memcpy((void*) newData, (void*) data(), sizeof(Entry) * Size);
+		if (Capacity > InlineCapacity)
+			DyckArena::deallocate(Arena, Heap, sizeof(Entry) * Capacity);
+		Heap = newData;
+		Capacity = newCap;
+	}
+
+public:
+	DyckEdgeMap(DyckArena* arena = NULL) :
+			Arena(arena), Size(0), Capacity(InlineCapacity) {
+	}
+
+	DyckEdgeMap(DyckEdgeMap&& other) :
+			Arena(other.Arena), Size(other.Size), Capacity(other.Capacity) {
+		memcpy(Inline, other.Inline, sizeof(Inline));
+		other.Size = 0;
+		other.Capacity = InlineCapacity;
+	}
+
+	DyckEdgeMap& operator=(DyckEdgeMap&& other) {
+		if (this != &other) {
+			this->~DyckEdgeMap();
+			new (this) DyckEdgeMap(std::move(other));
+		}
+		return *this;
+	}
+
+	DyckEdgeMap(const DyckEdgeMap&) = delete;
+	DyckEdgeMap& operator=(const DyckEdgeMap&) = delete;
+
+	~DyckEdgeMap() {
+		clear();
+	}
+
+	DyckArena* getArena() const {
+		return Arena;
+	}
+
+	iterator begin() {
+		return data();
+	}
+
+	iterator end() {
+		return data() + Size;
+	}
+
+	const_iterator begin() const {
+		return data();
+	}
+
+	const_iterator end() const {
+		return data() + Size;
+	}
+
+	unsigned size() const {
+		return Size;
+	}
+
+	bool empty() const {
+		return Size == 0;
+	}
+
+	iterator find(void* label) {
+		unsigned pos = lowerBound(label);
+		if (pos < Size && data()[pos].first == label)
+			return data() + pos;
+		return end();
+	}
+
+	/// Get the first vertex in the set of the label, which is the smallest unless the
+	/// set is large, or NULL if the label is not in the map. The first entry is checked before searching, so the vertex of
+	/// the smallest label is got by reading the inline entry.
+	DyckVertex* front(void* label) const {
+		const Entry* d = data();
+		if (Size && d[0].first == label)
+			return *d[0].second.begin();
+
+		unsigned pos = lowerBound(label);
+		if (pos < Size && d[pos].first == label)
+			return *d[pos].second.begin();
+		return NULL;
+	}
+
+	/// Add v to the set of the label. Return true if v is newly inserted.
+	bool insert(void* label, DyckVertex* v) {
+		return (*this)[label].insert(v, Arena);
+	}
+
+	/// Remove v from the set of the label, and the entry is removed if the set
+	/// becomes empty. Return the number of removed vertices, i.e. 0 or 1.
+	unsigned erase(void* label, DyckVertex* v) {
+		iterator it = find(label);
+		if (it == end() || !it->second.erase(v))
+			return 0;
+		if (it->second.empty())
+			erase(label);
+		return 1;
+	}
+
+	/// Get the set of the label, a new empty set is created if it does not exist.
+	/// Note that the returned reference is invalidated when another label is
+	/// inserted into or erased from the map.
+	DyckVertexSet& operator[](void* label) {
+		unsigned pos = lowerBound(label);
+		if (pos < Size && data()[pos].first == label)
+			return data()[pos].second;
+
+		if (Size == Capacity)
+			grow();
+
+		Entry* d = data();
+		memmove((void*) (d + pos + 1), (void*) (d + pos), sizeof(Entry) * (Size - pos));
+		new (d + pos) Entry(label);
+		Size++;
+		return d[pos].second;
+	}
+
+	/// Remove the entry of the label.
+	void erase(void* label) {
+		unsigned pos = lowerBound(label);
+		if (pos >= Size || data()[pos].first != label)
+			return;
+
+		Entry* d = data();
+		d[pos].second.release(Arena);
+		d[pos].~Entry();
+		memmove((void*) (d + pos), (void*) (d + pos + 1), sizeof(Entry) * (Size - pos - 1));
+		Size--;
+	}
+
+	void clear() {
+		Entry* d = data();
+		for (unsigned i = 0; i < Size; i++) {
+			d[i].second.release(Arena);
+			d[i].~Entry();
+		}
+		if (Capacity > InlineCapacity)
+			DyckArena::deallocate(Arena, Heap, sizeof(Entry) * Capacity);
+		Size = 0;
+		Capacity = InlineCapacity;
+	}
+
+	/// Replace each vertex v in the sets with f(v) without allocating memory.
+	template<class F>
+	void remap(F f) {
+		for (Entry* it = begin(); it != end(); it++)
+			it->second.remap(f);
+	}
+
+	/// Copy the entries and the sets to blocks of the exact sizes from the arena
+	/// of the map. The old blocks are not given back, which is only used when
+	/// they belong to another arena that is about to be destroyed.
+	void relocate() {
+		for (Entry* it = begin(); it != end(); it++)
+			it->second.relocate(Arena);
+
+		if (Capacity <= InlineCapacity)
+			return;
+
+		Entry* old = Heap;
+		if (Size <= InlineCapacity) {
+			memcpy((void*) Inline, (void*) old, sizeof(Entry) * Size);
+			Capacity = InlineCapacity;
+		} else {
+			Heap = (Entry*) DyckArena::allocate(Arena, sizeof(Entry) * Size);
+			memcpy((void*) Heap, (void*) old, sizeof(Entry) * Size);
+			Capacity = Size;
+		}
+	}
+
+	/// Forget all the entries without giving their memory back, which is
+	/// only used when the arena is about to be destroyed.
+	void abandon() {
+		assert(Arena);
+		Size = 0;
+		Capacity = InlineCapacity;
+	}
+
+	/// The number of edges in the map.
+	unsigned numEdges() const {
+		unsigned ret = 0;
+		for (const Entry* it = begin(); it != end(); it++)
+			ret += it->second.size();
+		return ret;
+	}
+
+	/// Heap memory used by the map, not including the map itself.
+	unsigned long heapBytes() const {
+		unsigned long ret = Capacity > InlineCapacity ? sizeof(Entry) * Capacity : 0;
+		for (const Entry* it = begin(); it != end(); it++)
+			ret += it->second.heapBytes();
+		return ret;
+	}
+};
+
+#endif	/* DYCKVERTEXSET_H */
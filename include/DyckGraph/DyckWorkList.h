@@ -0,0 +1,138 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#ifndef DYCKWORKLIST_H
+#define	DYCKWORKLIST_H
+
+#include <assert.h>
+#include <algorithm>
+#include <deque>
+#include <unordered_set>
+#include <vector>
+
+class DyckVertex;
+
+/// The work list of qirun's algorithm DyckGraph::qirunAlgorithm(), which
+/// contains the (vertex, label) pairs that have more than one target.
+///
+/// A pair is identified by the key packing the vertex index and the dense
+/// label id, so that testing and removing a pair take constant time.
+/// Pairs are popped in the order chosen by setOrder(); a removed pair stays
+/// in the queue until it is popped, and it is skipped then.
+class DyckWorkList {
+public:
+	/// The order in which the pairs are popped.
+	enum Order {
+		/// first in, first out
+		FIFO,
+		/// the pair whose vertex has the highest degree when it is pushed first
+		HIGHEST_DEGREE,
+		/// the pair whose label is the smallest first
+		LABEL_PRIORITY
+	};
+
+private:
+	struct Item {
+		DyckVertex* vertex;
+		void* label;
+		unsigned long long key;
+		unsigned long long priority;
+		unsigned long long seq;
+
+		/// for the max-heap, the pairs of the same priority are popped in FIFO order
+		bool operator<(const Item& other) const {
+			return priority < other.priority || (priority == other.priority && seq > other.seq);
+		}
+	};
+
+	Order order;
+	unsigned long long next_seq;
+
+	/// the queue of FIFO
+	std::deque<Item> queue;
+	/// the heap of the other orders
+	std::vector<Item> heap;
+
+	std::unordered_set<unsigned long long> members;
+
+public:
+	DyckWorkList() :
+			order(FIFO), next_seq(0) {
+	}
+
+	static unsigned long long key(unsigned vertexIndex, unsigned labelId) {
+		return ((unsigned long long) vertexIndex << 32) | labelId;
+	}
+
+	static unsigned vertexIndex(unsigned long long k) {
+		return (unsigned) (k >> 32);
+	}
+
+	Order getOrder() const {
+		return order;
+	}
+
+	/// The order can only be changed when the work list is empty.
+	void setOrder(Order o) {
+		assert(empty() && "The order of a non-empty work list cannot be changed!");
+		queue.clear();
+		heap.clear();
+		order = o;
+	}
+
+	bool empty() const {
+		return members.empty();
+	}
+
+	unsigned size() const {
+		return members.size();
+	}
+
+	bool contains(unsigned long long k) const {
+		return members.count(k);
+	}
+
+	/// Return true if the pair is newly added. The priority is ignored in FIFO order.
+	bool push(DyckVertex* v, void* label, unsigned long long k, unsigned long long priority = 0) {
+		if (!members.insert(k).second) {
+			return false;
+		}
+		Item item = { v, label, k, priority, next_seq++ };
+		if (order == FIFO) {
+			queue.push_back(item);
+		} else {
+			heap.push_back(item);
+			std::push_heap(heap.begin(), heap.end());
+		}
+		return true;
+	}
+
+	void remove(unsigned long long k) {
+		members.erase(k);
+	}
+
+	/// Pop the first pair that has not been removed, and return its key.
+	/// The work list must not be empty.
+	unsigned long long pop(DyckVertex*& v, void*& label) {
+		while (true) {
+			Item item;
+			if (order == FIFO) {
+				item = queue.front();
+				queue.pop_front();
+			} else {
+				std::pop_heap(heap.begin(), heap.end());
+				item = heap.back();
+				heap.pop_back();
+			}
+			if (members.erase(item.key)) {
+				v = item.vertex;
+				label = item.label;
+				return item.key;
+			}
+		}
+	}
+};
+
+#endif	/* DYCKWORKLIST_H */
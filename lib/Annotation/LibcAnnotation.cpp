@@ -4,6 +4,7 @@
  */
 
 #include "Annotation/LibcAnnotation.h"
+#include "Annotation/LibraryModel.h"
 
 #include <stdio.h>
 #include <algorithm>
@@ -21,20 +22,20 @@ RegisterPass<LibcAnnotation> Z("libca", "Annotate library c libs for optimizatio
 char LibcAnnotation::ID = 0;
 
 bool LibcAnnotation::runOnModule(Module & M) {
+    const LibraryModels& models = LibraryModels::get();
     for (ilist_iterator<Function> iterF = M.getFunctionList().begin(); iterF != M.getFunctionList().end(); iterF++) {
         Function* f = iterF;
         if (f->empty() && !f->isIntrinsic()) {
-            std::string name = f->getName().str();
-            if (name == "ftw") {
-                f->addAttribute(1, Attribute::ReadOnly);
+            const vector<LibraryEffect>* effects = models.lookup(f->getName());
+            if (effects == NULL) {
+                continue;
             }
 
-            if (name == "setlocale" || name == "setrlimit") {
-                f->addAttribute(2, Attribute::ReadOnly);
-            }
-
-            if (name == "getopt") {
-                f->addAttribute(3, Attribute::ReadOnly);
+            for (auto& effect : *effects) {
+                if (effect.kind == LibraryEffect::READONLY_ARG && (unsigned) effect.first < f->getFunctionType()->getNumParams()) {
+                    // attribute 0 is for the return value
+                    f->addAttribute(effect.first + 1, Attribute::ReadOnly);
+                }
             }
         }
     }
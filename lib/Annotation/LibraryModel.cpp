@@ -0,0 +1,205 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#include "Annotation/LibraryModel.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+static cl::opt<std::string> LibraryModelFile("library-models", cl::init(""), cl::Hidden,
+		cl::desc("A file of the models of library functions, see include/Annotation/LibraryModel.h."));
+
+LibraryModels::LibraryModels() {
+	const int Ret = LibraryEffect::Ret;
+	const int Any = LibraryEffect::AnyArgs;
+
+	const char* dups[] = { "strdup", "__strdup", "strdupa" };
+	for (auto name : dups) {
+		add(name, LibraryEffect::CONTENT_ALIAS, 1, 0, Ret);
+	}
+	add("pthread_getspecific", LibraryEffect::KEY_VALUE, 1, 0, Ret);
+
+	const char* cats[] = { "strcat", "strcpy" };
+	for (auto name : cats) {
+		add(name, LibraryEffect::CONTENT_ALIAS, 2, 0, 1);
+		add(name, LibraryEffect::ALIAS, 2, Ret, 0);
+	}
+	add("strndup", LibraryEffect::CONTENT_ALIAS, 2, 0, Ret);
+	add("strndupa", LibraryEffect::CONTENT_ALIAS, 2, 0, Ret);
+	add("strstr", LibraryEffect::CONTENT_ALIAS, 2, 1, Ret);
+	add("strstr", LibraryEffect::ALIAS, 2, Ret, 0);
+	add("strcasestr", LibraryEffect::CONTENT_ALIAS, 2, 1, Ret);
+	add("strcasestr", LibraryEffect::ALIAS, 2, Ret, 0);
+	const char* chrs[] = { "strchr", "strrchr", "strchrnul", "rawmemchr" };
+	for (auto name : chrs) {
+		add(name, LibraryEffect::ALIAS, 2, Ret, 0);
+	}
+	add("strtok", LibraryEffect::CONTENT_ALIAS, 2, 0, Ret);
+	add("pthread_setspecific", LibraryEffect::KEY_VALUE, 2, 0, 1);
+
+	const char* cpys[] = { "strncat", "strncpy", "memcpy", "memmove" };
+	for (auto name : cpys) {
+		add(name, LibraryEffect::CONTENT_ALIAS, 3, 0, 1);
+		add(name, LibraryEffect::ALIAS, 3, Ret, 0);
+	}
+	const char* mems[] = { "memchr", "memrchr", "memset" };
+	for (auto name : mems) {
+		add(name, LibraryEffect::ALIAS, 3, Ret, 0);
+	}
+	add("strtok_r", LibraryEffect::CONTENT_ALIAS, 3, 0, Ret);
+	add("__strtok_r", LibraryEffect::CONTENT_ALIAS, 3, 0, Ret);
+
+	add("pthread_create", LibraryEffect::THREAD_SPAWN, 4, 2, 3);
+
+	add("ftw", LibraryEffect::READONLY_ARG, Any, 0);
+	add("setlocale", LibraryEffect::READONLY_ARG, Any, 1);
+	add("setrlimit", LibraryEffect::READONLY_ARG, Any, 1);
+	add("getopt", LibraryEffect::READONLY_ARG, Any, 2);
+
+	if (!LibraryModelFile.empty()) {
+		string error;
+		if (!load(LibraryModelFile.c_str(), error)) {
+			errs() << "[Canary] The library models in " << LibraryModelFile << " are not loaded: " << error << "\n";
+		}
+	}
+}
+
+void LibraryModels::add(const char* name, LibraryEffect::Kind kind, int numArgs, int first, int second) {
+	LibraryEffect effect;
+	effect.kind = kind;
+	effect.numArgs = numArgs;
+	effect.first = first;
+	effect.second = second;
+	models[name].push_back(effect);
+}
+
+static bool parseOperand(const string& token, int& operand) {
+	if (token == "ret") {
+		operand = LibraryEffect::Ret;
+		return true;
+	}
+
+	char* end = NULL;
+	long n = strtol(token.c_str(), &end, 10);
+	if (token.empty() || *end != '\0' || n < 0) {
+		return false;
+	}
+	operand = (int) n;
+	return true;
+}
+
+bool LibraryModels::load(const char* file, string& error) {
+	ifstream in(file);
+	if (!in) {
+		error = "cannot open the file";
+		return false;
+	}
+
+	// the models are added after the whole file is parsed
+	vector<pair<string, LibraryEffect> > loaded;
+	string line;
+	unsigned lineNo = 0;
+	while (getline(in, line)) {
+		lineNo++;
+		size_t comment = line.find('#');
+		if (comment != string::npos) {
+			line.erase(comment);
+		}
+
+		istringstream tokens(line);
+		vector<string> fields;
+		string token;
+		while (tokens >> token) {
+			fields.push_back(token);
+		}
+		if (fields.empty()) {
+			continue;
+		}
+
+		LibraryEffect effect;
+		effect.second = LibraryEffect::Ret;
+		bool ok = fields.size() == 4 || fields.size() == 5;
+		if (ok) {
+			if (fields[1] == "*") {
+				effect.numArgs = LibraryEffect::AnyArgs;
+			} else {
+				ok = parseOperand(fields[1], effect.numArgs) && effect.numArgs != LibraryEffect::Ret;
+			}
+		}
+
+		if (ok) {
+			const string& kind = fields[2];
+			if (kind == "alias") {
+				effect.kind = LibraryEffect::ALIAS;
+			} else if (kind == "content-alias") {
+				effect.kind = LibraryEffect::CONTENT_ALIAS;
+			} else if (kind == "key-value") {
+				effect.kind = LibraryEffect::KEY_VALUE;
+			} else if (kind == "thread-spawn") {
+				effect.kind = LibraryEffect::THREAD_SPAWN;
+			} else if (kind == "readonly") {
+				effect.kind = LibraryEffect::READONLY_ARG;
+			} else {
+				ok = false;
+			}
+		}
+
+		if (ok) {
+			// readonly has one operand, and the others have two
+			ok = (effect.kind == LibraryEffect::READONLY_ARG) == (fields.size() == 4);
+			ok = ok && parseOperand(fields[3], effect.first);
+			ok = ok && (fields.size() == 4 || parseOperand(fields[4], effect.second));
+			ok = ok && (effect.kind != LibraryEffect::READONLY_ARG || effect.first != LibraryEffect::Ret);
+			ok = ok && (effect.kind != LibraryEffect::THREAD_SPAWN || (effect.first != LibraryEffect::Ret && effect.second != LibraryEffect::Ret));
+		}
+
+		if (!ok) {
+			ostringstream os;
+			os << "line " << lineNo << " is malformed";
+			error = os.str();
+			return false;
+		}
+		loaded.push_back(make_pair(fields[0], effect));
+	}
+
+	std::set<string> replaced;
+	for (auto& it : loaded) {
+		if (replaced.insert(it.first).second) {
+			models[it.first].clear();
+		}
+		models[it.first].push_back(it.second);
+	}
+	return true;
+}
+
+void LibraryModels::hash(MD5& hasher) const {
+	vector<StringRef> names;
+	for (auto& it : models) {
+		names.push_back(it.getKey());
+	}
+	std::sort(names.begin(), names.end());
+
+	for (auto name : names) {
+		hasher.update(name);
+		// the name is terminated, so that it is not mixed up with the effects
+		hasher.update(ArrayRef<uint8_t>((const uint8_t*) "", 1));
+		const vector<LibraryEffect>& effects = models.find(name)->second;
+		for (auto& effect : effects) {
+			int32_t words[] = { effect.kind, effect.numArgs, effect.first, effect.second };
+			hasher.update(ArrayRef<uint8_t>((const uint8_t*) words, sizeof(words)));
+		}
+	}
+}
+
+const LibraryModels& LibraryModels::get() {
+	// the options are parsed before any pass runs
+	static LibraryModels Models;
+	return Models;
+}
@@ -5,7 +5,15 @@
 
 #define DEBUG_TYPE "dyckaa"
 #include "DyckAA/AAAnalyzer.h"
+#include "DyckAA/DyckSummary.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
 #include <signal.h>
+#include <stdio.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 static cl::opt<bool> NoFunctionTypeCheck("no-function-type-check", cl::init(false), cl::Hidden,
 		cl::desc("Do not check function type when resolving pointer calls."));
@@ -16,7 +24,19 @@ static cl::opt<bool> WithFunctionCastComb("with-function-cast-comb", cl::init(fa
 static cl::opt<unsigned> NumInterIteration("dyckaa-inter-iteration", cl::init(UINT_MAX), cl::Hidden,
         cl::desc("The max number of iterators for fix-pointer computation during interprocedure analysis."));
 
-static Instruction* RunningInst = nullptr;
+static cl::opt<unsigned> IntraThreads("dyckaa-intra-threads", cl::init(1), cl::Hidden,
+		cl::desc("The number of threads used by the intra-procedural analysis."));
+
+static cl::opt<std::string> SummaryCache("dyckaa-summary-cache", cl::init(""), cl::Hidden,
+		cl::desc("The directory where the summaries of the functions are cached for the intra-procedural analysis."));
+
+static cl::opt<unsigned> FieldLimit("dyckaa-field-limit", cl::init(0), cl::Hidden,
+		cl::desc("Collapse the fields whose indices are not less than the limit into one field, 0 means no limit."));
+
+static cl::opt<unsigned> BulkAggregateSize("dyckaa-bulk-aggregate", cl::init(64), cl::Hidden,
+		cl::desc("Analyze a constant array or struct of more elements than it in bulk, 0 means never."));
+
+static thread_local Instruction* RunningInst = nullptr;
 
 static void OnSegmentFalut(int) {
     if (RunningInst) {
@@ -34,10 +54,37 @@ AAAnalyzer::AAAnalyzer(Module* m, DyckAliasAnalysis* a, DyckGraph* d, DyckCallGr
 	aa = a;
 	dgraph = d;
 	callgraph = cg;
+	owner = NULL;
+	region = NULL;
+	num_insts = 0;
+	num_collapsed_fields = 0;
+	num_bulk_aggregates = 0;
+	num_bulk_elements = 0;
+	num_loaded_summaries = 0;
+	num_saved_summaries = 0;
+}
+
+AAAnalyzer::AAAnalyzer(AAAnalyzer* o, DyckGraph* d) :
+		PB("[Canary]", DyckAA::ProgressBar::PBS_CharacterStyle) {
+	module = o->module;
+	aa = o->aa;
+	dgraph = d;
+	callgraph = o->callgraph;
+	owner = o;
+	region = o->region;
+	num_insts = 0;
+	num_collapsed_fields = 0;
+	num_bulk_aggregates = 0;
+	num_bulk_elements = 0;
+	num_loaded_summaries = 0;
+	num_saved_summaries = 0;
 }
 
 AAAnalyzer::~AAAnalyzer() {
 	this->destroyFunctionGroups();
+	if (owner) {
+		delete dgraph;
+	}
 }
 
 void AAAnalyzer::start_intra_procedure_analysis() {
@@ -59,7 +106,17 @@ void AAAnalyzer::end_inter_procedure_analysis() {
 void AAAnalyzer::intra_procedure_analysis() {
     signal(SIGSEGV, OnSegmentFalut);
 
-	long instNum = 0;
+	if (!SummaryCache.empty()) {
+		if (sys::fs::create_directories(SummaryCache.getValue())) {
+			errs() << "[Canary] The summary cache " << SummaryCache << " cannot be created, the summaries are not used.\n";
+		} else {
+			summary_dir = SummaryCache;
+		}
+	}
+
+	// a summary is saved from or loaded into the graph of a worker
+	bool perFunction = IntraThreads > 1 || !summary_dir.empty();
+
 	long intrinsicsNum = 0;
 	for (auto& F : *module) {
 		if (F.isIntrinsic()) {
@@ -67,24 +124,237 @@ void AAAnalyzer::intra_procedure_analysis() {
 			intrinsicsNum++;
 			continue;
 		}
-		DyckCallGraphNode* df = callgraph->getOrInsertFunction(&F);
-		for (auto& B : F) {
-			for (auto& I : B) {
-				RunningInst = &I;
-				instNum++;
-
-				DEBUG_WITH_TYPE("inst", errs() << *RunningInst << "\n");
-				handle_inst(RunningInst, df);
-			}
+		if (region && !F.empty() && !region->count(&F)) {
+			continue;
+		}
+		if (!perFunction) {
+			analyze_function(&F, callgraph->getOrInsertFunction(&F));
 		}
 	}
-	DEBUG_WITH_TYPE("dyckaa-stats", errs() << "\n# Instructions: " << instNum << "\n");
+	if (perFunction) {
+		parallel_intra_procedure_analysis(std::max(IntraThreads.getValue(), 1u));
+	}
+	DEBUG_WITH_TYPE("dyckaa-stats", errs() << "\n# Instructions: " << num_insts << "\n");
 	DEBUG_WITH_TYPE("dyckaa-stats", errs() << "# Functions: " << module->size() - intrinsicsNum << "\n");
+	if (region) {
+		DEBUG_WITH_TYPE("dyckaa-stats", errs() << "# Functions in the region: " << region->size() << "\n");
+	}
+	DEBUG_WITH_TYPE("dyckaa-stats", errs() << "# Vertices: " << dgraph->numVertices() << ", labels: " << dgraph->numLabels() << "\n");
+	if (num_bulk_aggregates) {
+		DEBUG_WITH_TYPE("dyckaa-stats", errs() << "# Aggregates in bulk: " << num_bulk_aggregates << ", "
+				<< num_bulk_elements << " nested aggregates without their own fields (-dyckaa-bulk-aggregate=" << BulkAggregateSize << ")\n");
+	}
+	if (FieldLimit) {
+		DEBUG_WITH_TYPE("dyckaa-stats", errs() << "# Collapsed fields: " << num_collapsed_fields
+				<< " (-dyckaa-field-limit=" << FieldLimit << ")\n");
+	}
+	if (!summary_dir.empty()) {
+		DEBUG_WITH_TYPE("dyckaa-stats", errs() << "# Summaries: " << num_loaded_summaries << " loaded, "
+				<< num_saved_summaries << " saved\n");
+	}
 
 	signal(SIGSEGV, SIG_DFL);
 	return;
 }
 
+void AAAnalyzer::hashOptions(MD5& hasher) {
+	uint32_t options[] = { NoFunctionTypeCheck, WithFunctionCastComb, NumInterIteration, FieldLimit };
+	hasher.update(ArrayRef<uint8_t>((const uint8_t*) options, sizeof(options)));
+	LibraryModels::get().hash(hasher);
+}
+
+bool AAAnalyzer::supportsRegion() {
+	// a region reaches the fixed point in fewer iterations than the whole module
+	return !WithFunctionCastComb && NumInterIteration == UINT_MAX;
+}
+
+void AAAnalyzer::analyze_function(Function* f, DyckCallGraphNode* df) {
+	for (auto& B : *f) {
+		for (auto& I : B) {
+			RunningInst = &I;
+			num_insts++;
+
+			DEBUG_WITH_TYPE("inst", errs() << *RunningInst << "\n");
+			handle_inst(RunningInst, df);
+		}
+	}
+}
+
+void AAAnalyzer::parallel_intra_procedure_analysis(unsigned threads) {
+	// the workers only look up the call graph, so all the nodes are created here,
+	// which also builds the arguments of the functions
+	vector<Function*> funcs;
+	vector<DyckCallGraphNode*> nodes;
+	for (auto& F : *module) {
+		if (F.isIntrinsic()) {
+			continue;
+		}
+		DyckCallGraphNode* df = callgraph->getOrInsertFunction(&F);
+		if (!F.empty() && (!region || region->count(&F))) {
+			funcs.push_back(&F);
+			nodes.push_back(df);
+		}
+	}
+
+	// the workers run ahead of the merging by at most window functions,
+	// so that the graphs waiting to be merged do not take too much memory
+	const size_t window = 4 * threads;
+	vector<AAAnalyzer*> workers(funcs.size(), NULL);
+	size_t next = 0, merged = 0;
+	mutex m;
+	condition_variable cv;
+
+	auto work = [&]() {
+		while (true) {
+			size_t i;
+			{
+				unique_lock<mutex> lock(m);
+				cv.wait(lock, [&]() {
+					return next >= funcs.size() || next < merged + window;
+				});
+				if (next >= funcs.size()) {
+					return;
+				}
+				i = next++;
+			}
+
+			AAAnalyzer* worker = new AAAnalyzer(this, new DyckGraph);
+			worker->build_function_graph(funcs[i], nodes[i]);
+
+			{
+				lock_guard<mutex> lock(m);
+				workers[i] = worker;
+			}
+			cv.notify_all();
+		}
+	};
+
+	vector<thread> pool;
+	for (unsigned t = 0; t < threads; t++) {
+		pool.push_back(thread(work));
+	}
+
+	// the graphs are merged in the order of the functions, so that the result
+	// does not depend on the scheduling of the threads
+	for (size_t i = 0; i < funcs.size(); i++) {
+		AAAnalyzer* worker = NULL;
+		{
+			unique_lock<mutex> lock(m);
+			cv.wait(lock, [&]() {
+				return workers[i] != NULL;
+			});
+			worker = workers[i];
+		}
+
+		merge_worker(worker);
+		num_insts += worker->num_insts;
+		num_collapsed_fields += worker->num_collapsed_fields;
+		num_loaded_summaries += worker->num_loaded_summaries;
+		num_saved_summaries += worker->num_saved_summaries;
+		delete worker;
+
+		{
+			lock_guard<mutex> lock(m);
+			merged = i + 1;
+		}
+		cv.notify_all();
+	}
+
+	for (auto& th : pool) {
+		th.join();
+	}
+}
+
+void AAAnalyzer::build_function_graph(Function* f, DyckCallGraphNode* df) {
+	const string& dir = owner->summary_dir;
+	uint64_t hash = dir.empty() ? 0 : DyckSummary::hash(f, FieldLimit);
+
+	SmallString<128> file;
+	if (hash) {
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.dsum", (unsigned long long) hash);
+		file = dir;
+		sys::path::append(file, name);
+		if (DyckSummary::load(file.c_str(), f, hash, dgraph, df, aa->edge_labels, deferred_constants, deferred_casts,
+				deferred_implicit_calls)) {
+			num_loaded_summaries++;
+			return;
+		}
+	}
+
+	analyze_function(f, df);
+	// a normalized graph has fewer vertices and edges to merge
+	dgraph->qirunAlgorithm();
+
+	if (hash && DyckSummary::save(file.c_str(), f, hash, dgraph, df, aa->edge_labels, deferred_constants, deferred_casts,
+			deferred_implicit_calls)) {
+		num_saved_summaries++;
+	}
+}
+
+void AAAnalyzer::merge_worker(AAAnalyzer* worker) {
+	// the constants are analyzed before their vertices are merged
+	for (auto c : worker->deferred_constants) {
+		wrapValue(c);
+	}
+
+	for (auto cast : worker->deferred_casts) {
+		Type* origTy = cast->getOperand(0)->getType();
+		combineFunctionGroups((FunctionType*) origTy->getPointerElementType(), (FunctionType*) cast->getType()->getPointerElementType());
+	}
+
+	// the reps of the worker in the order of their creation
+	vector<DyckVertex*> reps;
+	for (auto v : worker->dgraph->getVertices()) {
+		if (v != NULL) {
+			reps.push_back(v);
+		}
+	}
+
+	// the values of a rep are combined here, and a rep without values gets a new vertex
+	unordered_map<DyckVertex*, DyckVertex*> repMap;
+	vector<Value*> anchors(reps.size(), NULL);
+	for (unsigned i = 0; i < reps.size(); i++) {
+		set<void*>* vals = reps[i]->getEquivalentSet();
+		if (vals->empty()) {
+			repMap[reps[i]] = dgraph->retrieveDyckVertex(nullptr).first;
+			continue;
+		}
+
+		DyckVertex* ver = NULL;
+		for (auto val : *vals) {
+			DyckVertex* valVer = dgraph->retrieveDyckVertex(val).first;
+			ver = ver ? makeAlias(ver, valVer) : valVer;
+		}
+		anchors[i] = (Value*) *vals->begin();
+	}
+
+	// a vertex may have been combined into another one, so it is looked up again
+	for (unsigned i = 0; i < reps.size(); i++) {
+		if (anchors[i]) {
+			repMap[reps[i]] = dgraph->findDyckVertex(anchors[i]);
+		}
+	}
+
+	for (auto rep : reps) {
+		DyckVertex* src = repMap[rep];
+		for (auto& out : rep->getOutVertices()) {
+			for (auto tar : out.second) {
+				DyckVertex* dst = repMap[tar];
+				if (!src->containsTarget(dst, out.first)) {
+					src->addTarget(dst, out.first);
+				}
+			}
+		}
+	}
+
+	for (auto& call : worker->deferred_implicit_calls) {
+		vector<Value*> xargs;
+		xargs.push_back(std::get<2>(call));
+		handle_invoke_call_inst(nullptr, std::get<1>(call), &xargs, callgraph->getOrInsertFunction(std::get<0>(call)));
+	}
+}
+
 void AAAnalyzer::inter_procedure_analysis() {
 	// The following three variables control the progress bar.
 	// IterationCounter records the number of iterations so far.
@@ -100,67 +370,112 @@ void AAAnalyzer::inter_procedure_analysis() {
 	unsigned IterationPhase = 0;
 	const unsigned InterationStep = 5;
 
-	map<DyckCallGraphNode*, set<CommonCall*>> handledCommonCalls;
+	// all the calls are new in the first iteration
+	new_common_calls.clear();
+	new_pointer_calls.clear();
+	for (auto& it : *callgraph) {
+		DyckCallGraphNode * df = it.second;
+		for (auto c : df->getCommonCalls()) {
+			new_common_calls.push_back(make_pair(c, df));
+		}
+		for (auto pc : df->getPointerCalls()) {
+			new_pointer_calls.push_back(make_pair(pc, df));
+		}
+	}
+
+	// A pointer call only needs to be revisited when the equivalent set of its called
+	// value is changed, i.e. its rep takes part in a merge. The pointer calls and the
+	// address-taken functions are indexed by the reps in rep_infos.
+	map<Function*, vector<FunctionTypeNode*> > funcGroups;
+	for (auto& it : tyroots) {
+		for (auto f : it.second->compatibleFuncs) {
+			funcGroups[f].push_back(it.second);
+		}
+	}
+	// the functions that have not been wrapped yet
+	vector<Function*> unindexedFuncs;
+	for (auto& fg : funcGroups) {
+		unindexedFuncs.push_back(fg.first);
+	}
+
+	set<unsigned> dirtyReps;
+	vector<pair<unsigned, unsigned> > merges;
+	dgraph->setTrackMerges(true);
+
 	while (1) {
         if (IterationCounter++ >= NumInterIteration.getValue()) {
             break;
         }
 
-        // outs() << "\n\nIteration #" << IterationCounter << "... \n\n";
-        // outs() << "Phase: " << IterationPhase << "\n\n";
-
 		bool finished = true;
 		dgraph->qirunAlgorithm();
 
-		{ // direct calls
-			//outs() << "Handling direct calls...";
-			outs().flush();
-			auto dfit = callgraph->begin();
-			while (dfit != callgraph->end()) {
-				DyckCallGraphNode * df = dfit->second;
-				set<CommonCall*>& df_handledCommonCalls = handledCommonCalls[df];
-				set<CommonCall*>& df_commonCalls = df->getCommonCalls();
-
-				// df_unHandledCommonCalls = df_commonCalls - df_handledCommonCalls
-				set<CommonCall*> df_unHandledCommonCalls;
-				set_difference(df_commonCalls.begin(), df_commonCalls.end(), df_handledCommonCalls.begin(), df_handledCommonCalls.end(),
-						inserter(df_unHandledCommonCalls, df_unHandledCommonCalls.begin()));
-
-				auto cit = df_unHandledCommonCalls.begin();
-				while (cit != df_unHandledCommonCalls.end()) {
-					finished = false;
-					CommonCall * theComCall = *cit;
-					df_handledCommonCalls.insert(theComCall);
+		dgraph->takeMerges(merges);
+		dirtyReps.clear();
+		for (auto& m : merges) {
+			dirtyReps.insert(m.first);
+			dirtyReps.erase(m.second);
+			merge_rep_info(m.first, m.second);
+		}
 
-					Value * cv = theComCall->calledValue;
-					assert(isa<Function>(cv) && "Error: it is not a function in common calls!");
-					handle_common_function_call(theComCall, df, callgraph->getOrInsertFunction((Function*) cv));
-					cit++;
-				}
-				// ---------------------------------------------------
-				++dfit;
+		// a function added into an equivalent set changes the set
+		auto fit = unindexedFuncs.begin();
+		while (fit != unindexedFuncs.end()) {
+			DyckVertex* fver = dgraph->findDyckVertex(*fit);
+			if (fver == NULL) {
+				++fit;
+				continue;
+			}
+			auto& functions = rep_infos[fver->getIndex()].functions;
+			for (auto root : funcGroups[*fit]) {
+				functions[root].insert(*fit);
 			}
-			//outs() << "Done!\n";
+			dirtyReps.insert(fver->getIndex());
+			fit = unindexedFuncs.erase(fit);
 		}
 
-		{ // indirect call
-			int NumProcessedFunctions = 0;
-			auto dfit = callgraph->begin();
-			while (dfit != callgraph->end()) {
-				DyckCallGraphNode * df = dfit->second;
+		vector<pair<PointerCall*, DyckCallGraphNode*> > dirtyCalls;
+		for (auto rep : dirtyReps) {
+			auto it = rep_infos.find(rep);
+			if (it != rep_infos.end()) {
+				auto& calls = it->second.pointerCalls;
+				dirtyCalls.insert(dirtyCalls.end(), calls.begin(), calls.end());
+			}
+		}
+		for (auto& pc : new_pointer_calls) {
+			rep_infos[wrapValue(pc.first->calledValue)->getIndex()].pointerCalls.push_back(pc);
+			dirtyCalls.push_back(pc);
+		}
+		new_pointer_calls.clear();
+
+		DEBUG_WITH_TYPE("dyckaa-stats", errs() << "# Iteration " << IterationCounter << ": " << merges.size() << " merges, "
+				<< new_common_calls.size() << " direct calls, " << dirtyCalls.size() << " pointer calls\n");
+
+		{ // direct calls
+			vector<pair<CommonCall*, DyckCallGraphNode*> > commonCalls;
+			commonCalls.swap(new_common_calls);
+			for (auto& cc : commonCalls) {
+				finished = false;
+				Value * cv = cc.first->calledValue;
+				assert(isa<Function>(cv) && "Error: it is not a function in common calls!");
+				handle_common_function_call(cc.first, cc.second, callgraph->getOrInsertFunction((Function*) cv));
+			}
+		}
 
-				if (handle_pointer_function_calls(df, ++NumProcessedFunctions)) {
+		{ // indirect call
+			unsigned NumProcessedCalls = 0;
+			for (auto& pc : dirtyCalls) {
+				if (handle_pointer_function_call(pc.first, pc.second)) {
 					finished = false;
 				}
 
-				PB.showProgress((NumProcessedFunctions + callgraph->size() * (IterationCounter - 1))
-						/ ((float) callgraph->size() * (InterationStep * (IterationPhase + 1))));
-
-				++dfit;
+				PB.showProgress((++NumProcessedCalls / (float) dirtyCalls.size() + (IterationCounter - 1))
+						/ (InterationStep * (IterationPhase + 1)));
 			}
 		}
 
-		if (finished) {
+		// the calls found when handling the pointer calls are handled in the next iteration
+		if (finished && new_common_calls.empty() && new_pointer_calls.empty()) {
 			break;
 		}
 
@@ -170,6 +485,8 @@ void AAAnalyzer::inter_procedure_analysis() {
 			PB.reset();
 		}
 	}
+	dgraph->setTrackMerges(false);
+	rep_infos.clear();
 
 	PB.showProgress(1);
 	printf("\n");
@@ -207,64 +524,14 @@ void AAAnalyzer::printNoAliasedPointerCalls() {
 
 //// The followings are private functions
 
-int AAAnalyzer::isCompatible(FunctionType * t1, FunctionType * t2) {
+uint64_t AAAnalyzer::getCompatibilityKey(FunctionType * fty) {
 	if (NoFunctionTypeCheck) {
-		return 1;
-	}
-
-	if (t1 == t2) {
-		return 1;
-	}
-
-	if (t1->isVarArg() != t2->isVarArg()) {
 		return 0;
 	}
 
-	Type* retty1 = t1->getReturnType();
-	Type* retty2 = t2->getReturnType();
-
-	if (retty1->isVoidTy() != retty2->isVoidTy()) {
-		return 0;
-	}
-
-	unsigned pn1 = t1->getNumParams();
-	unsigned pn2 = t2->getNumParams();
-
-	if (pn1 == pn2) {
-		bool level2 = true;
-		for (unsigned i = 0; i < pn1; i++) {
-			if (aa->getTypeStoreSize(t1->getParamType(i)) != aa->getTypeStoreSize(t2->getParamType(i))) {
-				level2 = false;
-				break;
-			}
-		}
-
-		if (level2)
-			return 2;
-
-		bool level3 = true;
-		for (unsigned i = 0; i < pn1; i++) {
-			Type* tp1 = t1->getParamType(i);
-			Type* tp2 = t2->getParamType(i);
-
-			if (tp1->isIntegerTy() != tp2->isIntegerTy()) {
-				level3 = false;
-				break;
-			}
-
-			if (tp1->isPointerTy() != tp2->isPointerTy()) {
-				level3 = false;
-				break;
-			}
-		}
-
-		if (level3)
-			return 3;
-
-		return 4;
-	} else {
-		return 0;
-	}
+	// the types with different varargs, different void returns or different
+	// numbers of parameters are not compatible, and the others are
+	return ((uint64_t) fty->getNumParams() << 2) | (fty->isVarArg() ? 2 : 0) | (fty->getReturnType()->isVoidTy() ? 1 : 0);
 }
 
 FunctionTypeNode* AAAnalyzer::initFunctionGroup(FunctionType* fty) {
@@ -272,20 +539,16 @@ FunctionTypeNode* AAAnalyzer::initFunctionGroup(FunctionType* fty) {
 		return functionTyNodeMap[fty]->root;
 	}
 
-	// iterate all roots to check whether compatible
-	// if so, add it to its set
-	// otherwise, new a root
-	set<FunctionTypeNode *>::iterator rit = tyroots.begin();
-	while (rit != tyroots.end()) {
-		if (isCompatible((*rit)->type, fty)) {
-			FunctionTypeNode * tn = new FunctionTypeNode;
-			tn->type = fty;
-			tn->root = (*rit);
+	// the types compatible with each other share a root
+	uint64_t key = getCompatibilityKey(fty);
+	auto rit = tyroots.find(key);
+	if (rit != tyroots.end()) {
+		FunctionTypeNode * tn = new FunctionTypeNode;
+		tn->type = fty;
+		tn->root = rit->second;
 
-			functionTyNodeMap.insert(pair<Type*, FunctionTypeNode*>(fty, tn));
-			return *rit;
-		}
-		rit++;
+		functionTyNodeMap.insert(pair<Type*, FunctionTypeNode*>(fty, tn));
+		return rit->second;
 	}
 
 	// not found compatible ones, create a new one
@@ -293,7 +556,7 @@ FunctionTypeNode* AAAnalyzer::initFunctionGroup(FunctionType* fty) {
 	tn->type = fty;
 	tn->root = tn;
 
-	tyroots.insert(tn);
+	tyroots.insert(make_pair(key, tn));
 	functionTyNodeMap.insert(pair<Type*, FunctionTypeNode*>(fty, tn));
 	return tn;
 }
@@ -357,17 +620,27 @@ void AAAnalyzer::combineFunctionGroups(FunctionType * ft1, FunctionType* ft2) {
 
 /// return the structure's field vertex
 
-DyckVertex* AAAnalyzer::addField(DyckVertex* val, long fieldIndex, DyckVertex* field) {
+DyckVertex* AAAnalyzer::addField(DyckVertex* val, long fieldIndex, DyckVertex* field, long* labelIndex) {
+	// the fields from -dyckaa-field-limit are one field
+	bool collapsed = FieldLimit && fieldIndex > (long) FieldLimit;
+	if (collapsed) {
+		fieldIndex = FieldLimit;
+	}
+	if (labelIndex) {
+		*labelIndex = fieldIndex;
+	}
+
+	void* label = (void*) (aa->getOrInsertIndexEdgeLabel(fieldIndex));
 	if (!field) {
-		set<DyckVertex*>* valrepset = val->getOutVertices((void*) (aa->getOrInsertIndexEdgeLabel(fieldIndex)));
-		if (valrepset && !valrepset->empty()) {
-			field = *(valrepset->begin());
-		} else {
+		field = val->getOutVertex(label);
+		if (!field) {
 			field = dgraph->retrieveDyckVertex(nullptr).first;
-			val->addTarget(field, (void*) (aa->getOrInsertIndexEdgeLabel(fieldIndex)));
+			val->addTarget(field, label);
+			num_collapsed_fields += collapsed;
 		}
-	} else {
-		val->addTarget(field, (void*) (aa->getOrInsertIndexEdgeLabel(fieldIndex)));
+	} else if (!val->containsTarget(field, label)) {
+		val->addTarget(field, label);
+		num_collapsed_fields += collapsed;
 	}
 
 	return field;
@@ -384,10 +657,8 @@ DyckVertex* AAAnalyzer::addPtrTo(DyckVertex* address, DyckVertex* val) {
 		address->addTarget(val, (void*) aa->DEREF_LABEL);
 		return address;
 	} else if (!val) {
-		set<DyckVertex*>* derefset = address->getOutVertices((void*) aa->DEREF_LABEL);
-		if (derefset && !derefset->empty()) {
-			val = *(derefset->begin());
-		} else {
+		val = address->getOutVertex((void*) aa->DEREF_LABEL);
+		if (!val) {
 			val = dgraph->retrieveDyckVertex(nullptr).first;
 			address->addTarget(val, (void*) aa->DEREF_LABEL);
 		}
@@ -432,8 +703,8 @@ DyckVertex* AAAnalyzer::handle_gep(GEPOperator* gep) {
 			assert(ci && "ERROR: when dealing with gep");
 
 			// s2: ?3--deref-->?2
-			unsigned fieldIdx = (unsigned) (*(ci->getValue().getRawData()));
-			DyckVertex* field = this->addField(theStruct, fieldIdx, nullptr);
+			long fieldIdx = 0;
+			DyckVertex* field = this->addField(theStruct, (unsigned) (*(ci->getValue().getRawData())), nullptr, &fieldIdx);
 			DyckVertex* fieldPtr = this->addPtrTo(nullptr, field);
 
 			// the label representation and feature impl is temporal.
@@ -463,6 +734,12 @@ DyckVertex* AAAnalyzer::wrapValue(Value * v) {
 	}
 	DyckVertex* vdv = retpair.first;
 
+	if (owner && isa<Constant>(v)) {
+		// constants may be used by many functions, so a worker leaves them to its owner
+		deferred_constants.push_back(v);
+		return vdv;
+	}
+
 	// constantTy are handled as below.
 	if (isa<ConstantExpr>(v)) {
 		unsigned opcode = ((ConstantExpr*) v)->getOpcode();
@@ -477,14 +754,14 @@ DyckVertex* AAAnalyzer::wrapValue(Value * v) {
 		} else if (opcode == Instruction::Select) {
 			wrapValue(((ConstantExpr*) v)->getOperand(0));
 			DyckVertex * opt0 = wrapValue(((ConstantExpr*) v)->getOperand(1));
-            if (dgraph->getVertices().count(opt0)) {
+            if (dgraph->containsVertex(opt0)) {
                 // FIXME: select instruction can be cyclic so we need a fixed-point algorithm
                 vdv = wrapValue(v);
-                assert(dgraph->getVertices().count(vdv));
+                assert(dgraph->containsVertex(vdv));
                 vdv = makeAlias(vdv, opt0);
-                assert(dgraph->getVertices().count(vdv));
+                assert(dgraph->containsVertex(vdv));
                 DyckVertex * opt1 = wrapValue(((ConstantExpr*) v)->getOperand(2));
-                if (dgraph->getVertices().count(vdv) && dgraph->getVertices().count(opt1)) {
+                if (dgraph->containsVertex(vdv) && dgraph->containsVertex(opt1)) {
                     vdv = makeAlias(vdv, opt1);
                 }
             }
@@ -540,13 +817,20 @@ DyckVertex* AAAnalyzer::wrapValue(Value * v) {
 	} else if (isa<ConstantStruct>(v) || isa<ConstantArray>(v)) {
 		Constant * vAgg = (Constant*) v;
 		unsigned numElmt = vAgg->getNumOperands();
-		for (unsigned i = 0; i < numElmt; i++) {
-			Value * vi = vAgg->getOperand(i);
+		if (BulkAggregateSize && numElmt > BulkAggregateSize) {
+			// e.g. a table of options or callbacks
+			num_bulk_aggregates++;
+			vector<long> path;
+			handle_constant_aggregate(vAgg, path, vAgg);
+		} else {
+			for (unsigned i = 0; i < numElmt; i++) {
+				Value * vi = vAgg->getOperand(i);
 
-			std::vector<unsigned> indices;
-			indices.push_back(i);
-			ArrayRef<unsigned> indicesRef(indices);
-			this->handle_extract_insert_value_inst(v, vAgg->getType(), indicesRef, vi);
+				std::vector<unsigned> indices;
+				indices.push_back(i);
+				ArrayRef<unsigned> indicesRef(indices);
+				this->handle_extract_insert_value_inst(v, vAgg->getType(), indicesRef, vi);
+			}
 		}
 		vdv = wrapValue(v);
 	} else if (isa<ConstantVector>(v)) {
@@ -721,11 +1005,6 @@ void AAAnalyzer::handle_instrinsic(Instruction *inst) {
 	wrapValue(call->getCalledValue());
 }
 
-set<Function*>* AAAnalyzer::getCompatibleFunctions(FunctionType * fty) {
-	FunctionTypeNode * ftn = this->initFunctionGroup(fty);
-	return &(ftn->root->compatibleFuncs);
-}
-
 void AAAnalyzer::handle_inst(Instruction *inst, DyckCallGraphNode * parent_func) {
 	int mask = 0;
 
@@ -893,7 +1172,12 @@ void AAAnalyzer::handle_inst(Instruction *inst, DyckCallGraphNode * parent_func)
 
 		if (origTy->isPointerTy() && origTy->getPointerElementType()->isFunctionTy() && castTy->isPointerTy()
 				&& castTy->getPointerElementType()->isFunctionTy()) {
-			combineFunctionGroups((FunctionType*) origTy->getPointerElementType(), (FunctionType*) castTy->getPointerElementType());
+			if (owner) {
+				// the function groups are shared by the functions
+				deferred_casts.push_back(inst);
+			} else {
+				combineFunctionGroups((FunctionType*) origTy->getPointerElementType(), (FunctionType*) castTy->getPointerElementType());
+			}
 		}
 
 		mask |= (~0);
@@ -1017,6 +1301,45 @@ void AAAnalyzer::handle_extract_insert_value_inst(Value* aggV, Type* aggTy, Arra
 	}
 }
 
+void AAAnalyzer::handle_constant_aggregate(Constant* outermost, vector<long>& path, Constant* agg) {
+	// the vertex at the path, which is looked up every time since wrapping an element
+	// may combine the vertices of the aggregate
+	auto getPlace = [this, outermost, &path]() {
+		DyckVertex* place = dgraph->findDyckVertex(outermost);
+		for (auto idx : path) {
+			place = this->addField(place, idx, nullptr);
+		}
+		return place;
+	};
+
+	bool isStruct = isa<ConstantStruct>(agg);
+	unsigned numElmt = agg->getNumOperands();
+	for (unsigned i = 0; i < numElmt; i++) {
+		Constant* elmt = agg->getOperand(i);
+		if ((isa<ConstantStruct>(elmt) || isa<ConstantArray>(elmt)) && !dgraph->findDyckVertex(elmt)) {
+			// the element of an array is the array, and the field of a struct is the field vertex
+			if (isStruct) {
+				path.push_back(i);
+			}
+			num_bulk_elements++;
+			makeAlias(getPlace(), dgraph->retrieveDyckVertex(elmt).first);
+			handle_constant_aggregate(outermost, path, elmt);
+			if (isStruct) {
+				path.pop_back();
+			}
+			continue;
+		}
+
+		// as handle_extract_insert_value_inst() does
+		DyckVertex* elmtVer = wrapValue(elmt);
+		if (isStruct) {
+			addField(getPlace(), i, elmtVer);
+		} else {
+			makeAlias(getPlace(), elmtVer);
+		}
+	}
+}
+
 void AAAnalyzer::handle_extract_insert_elmt_inst(Value* v, Value* elmt) {
 	auto elmtVer = wrapValue(elmt);
 	auto vecVer = wrapValue(v);
@@ -1030,7 +1353,9 @@ void AAAnalyzer::handle_invoke_call_inst(Instruction * ret, Value* cv, vector<Va
 			handle_instrinsic((Instruction*) ret);
 		} else {
 			this->handle_lib_invoke_call_inst(ret, (Function*) cv, args, parent);
-			parent->addCommonCall(new CommonCall(ret, (Function*) cv, args));
+			CommonCall* call = new CommonCall(ret, (Function*) cv, args);
+			parent->addCommonCall(call);
+			new_common_calls.push_back(make_pair(call, parent));
 		}
 	} else {
 		wrapValue(cv);
@@ -1043,10 +1368,13 @@ void AAAnalyzer::handle_invoke_call_inst(Instruction * ret, Value* cv, vector<Va
 
 			if (isa<Function>(cvcopy)) {
 				this->handle_lib_invoke_call_inst(ret, (Function*) cvcopy, args, parent);
-				parent->addCommonCall(new CommonCall(ret, (Function*) cvcopy, args));
+				CommonCall* call = new CommonCall(ret, (Function*) cvcopy, args);
+				parent->addCommonCall(call);
+				new_common_calls.push_back(make_pair(call, parent));
 			} else {
 				PointerCall* pcall = new PointerCall(ret, cv, args);
 				parent->addPointerCall(pcall);
+				new_pointer_calls.push_back(make_pair(pcall, parent));
 			}
 		} else if (isa<GlobalAlias>(cv)) {
 			Value * cvcopy = cv;
@@ -1056,14 +1384,18 @@ void AAAnalyzer::handle_invoke_call_inst(Instruction * ret, Value* cv, vector<Va
 
 			if (isa<Function>(cvcopy)) {
 				this->handle_lib_invoke_call_inst(ret, (Function*) cvcopy, args, parent);
-				parent->addCommonCall(new CommonCall(ret, (Function*) cvcopy, args));
+				CommonCall* call = new CommonCall(ret, (Function*) cvcopy, args);
+				parent->addCommonCall(call);
+				new_common_calls.push_back(make_pair(call, parent));
 			} else {
 				PointerCall* pcall = new PointerCall(ret, cv, args);
 				parent->addPointerCall(pcall);
+				new_pointer_calls.push_back(make_pair(pcall, parent));
 			}
 		} else {
 			PointerCall * pcall = new PointerCall(ret, cv, args);
 			parent->addPointerCall(pcall);
+			new_pointer_calls.push_back(make_pair(pcall, parent));
 		}
 	}
 }
@@ -1160,169 +1492,135 @@ void AAAnalyzer::handle_common_function_call(Call* c, DyckCallGraphNode* caller,
 	}
 }
 
-bool AAAnalyzer::handle_pointer_function_calls(DyckCallGraphNode* caller, int FUNCTION_COUNT) {
-	bool ret = false;
+bool AAAnalyzer::handle_pointer_function_call(PointerCall* pcall, DyckCallGraphNode* caller) {
+	if (pcall->mustAliasedPointerCall) {
+		return false;
+	}
 
-	set<PointerCall*>& pointercalls = caller->getPointerCalls();
-	set<PointerCall*>::iterator mit = pointercalls.begin();
-
-	// print in console
-	int PTCALL_TOTAL = pointercalls.size();
-	int PTCALL_COUNT = 0;
-//	if (PTCALL_TOTAL == 0)
-//		outs() << "Handling indirect calls in Function #" << FUNCTION_COUNT << "... 100%, 100%. Done!\r";
-
-	while (mit != pointercalls.end()) {
-		// print in console
-		int percentage = ((++PTCALL_COUNT) * 100 / PTCALL_TOTAL);
-//		outs() << "Handling indirect calls in Function #" << FUNCTION_COUNT << "... " << percentage << "%, \r";
-
-		PointerCall * pcall = *mit;
-		Type* fty = pcall->calledValue->getType()->getPointerElementType();
-		assert(fty->isFunctionTy() && "Error in AAAnalyzer::handle_pointer_function_calls!");
-
-		// handle each unhandled, possible function
-		set<Value*> equivAndTypeCompSet;
-		const set<Value*>* equivSet = aa->getAliasSet(pcall->calledValue);
-		set<Function*>* cands = this->getCompatibleFunctions((FunctionType*) fty);
-		set_intersection(cands->begin(), cands->end(), equivSet->begin(), equivSet->end(),
-				inserter(equivAndTypeCompSet, equivAndTypeCompSet.begin()));
-
-		set<Value*> unhandled_function;
-		set<Function*>* maycallfuncs = &(pcall->mayAliasedCallees);
-		set_difference(equivAndTypeCompSet.begin(), equivAndTypeCompSet.end(), maycallfuncs->begin(), maycallfuncs->end(),
-				inserter(unhandled_function, unhandled_function.begin()));
-
-		// print in console
-		int CAND_TOTAL = unhandled_function.size();
-		int CAND_COUNT = 0;
-		if (CAND_TOTAL == 0 || pcall->mustAliasedPointerCall) {
-//			outs() << "Handling indirect calls in Function #" << FUNCTION_COUNT << "... " << "100%, 100%. Done!\r";
-			mit++;
-			continue;
-		}
+	Type* fty = pcall->calledValue->getType()->getPointerElementType();
+	assert(fty->isFunctionTy() && "Error in AAAnalyzer::handle_pointer_function_call!");
 
-		auto pfit = unhandled_function.begin();
-		while (pfit != unhandled_function.end()) {
-			Function * mayAliasedFunctioin = (Function*) (*pfit);
-			// print in console
-			int RATE = ((100 * (++CAND_COUNT)) / CAND_TOTAL);
-			if (percentage == 100 && RATE == 100) {
-//				outs() << "Handling indirect calls in Function #" << FUNCTION_COUNT << "... " << "100%, 100%. Done!\r";
-			} else {
-//				outs() << "Handling indirect calls in Function #" << FUNCTION_COUNT << "... " << percentage << "%, " << RATE << "%         \r";
-			}
+	// the compatible functions in the equivalent set of the called value
+	auto rit = rep_infos.find(wrapValue(pcall->calledValue)->getIndex());
+	if (rit == rep_infos.end()) {
+		return false;
+	}
+	auto cit = rit->second.functions.find(this->initFunctionGroup((FunctionType*) fty));
+	if (cit == rit->second.functions.end()) {
+		return false;
+	}
+	set<Function*>& cands = cit->second;
 
-			AliasAnalysis::AliasResult ar = aa->alias(mayAliasedFunctioin, pcall->calledValue);
-			if (ar == AliasAnalysis::MayAlias || ar == AliasAnalysis::MustAlias) {
-				ret = true;
-				maycallfuncs->insert(mayAliasedFunctioin);
-
-				handle_common_function_call(pcall, caller, callgraph->getOrInsertFunction(mayAliasedFunctioin));
-				handle_lib_invoke_call_inst(pcall->instruction, mayAliasedFunctioin, &(pcall->args), caller);
-
-				if (ar == AliasAnalysis::MustAlias) {
-					// print in console
-					pcall->mustAliasedPointerCall = true;
-					pcall->mayAliasedCallees.clear();
-					pcall->mayAliasedCallees.insert(mayAliasedFunctioin);
-//					outs() << "Handling indirect calls in Function #" << FUNCTION_COUNT << "... " << "100%, 100%. Done!\r";
-					break;
-				}
+	// handle each unhandled, possible function
+	set<Function*> unhandled_function;
+	set<Function*>* maycallfuncs = &(pcall->mayAliasedCallees);
+	set_difference(cands.begin(), cands.end(), maycallfuncs->begin(), maycallfuncs->end(),
+			inserter(unhandled_function, unhandled_function.begin()));
+
+	bool ret = false;
+	auto pfit = unhandled_function.begin();
+	while (pfit != unhandled_function.end()) {
+		Function * mayAliasedFunctioin = *pfit;
+
+		AliasAnalysis::AliasResult ar = aa->alias(mayAliasedFunctioin, pcall->calledValue);
+		if (ar == AliasAnalysis::MayAlias || ar == AliasAnalysis::MustAlias) {
+			ret = true;
+			maycallfuncs->insert(mayAliasedFunctioin);
+
+			handle_common_function_call(pcall, caller, callgraph->getOrInsertFunction(mayAliasedFunctioin));
+			handle_lib_invoke_call_inst(pcall->instruction, mayAliasedFunctioin, &(pcall->args), caller);
+
+			if (ar == AliasAnalysis::MustAlias) {
+				pcall->mustAliasedPointerCall = true;
+				pcall->mayAliasedCallees.clear();
+				pcall->mayAliasedCallees.insert(mayAliasedFunctioin);
+				break;
 			}
-			pfit++;
 		}
-
-		mit++;
+		pfit++;
 	}
 
 	return ret;
 }
 
+void AAAnalyzer::merge_rep_info(unsigned rep, unsigned merged) {
+	auto mit = rep_infos.find(merged);
+	if (mit == rep_infos.end()) {
+		return;
+	}
+	RepInfo mergedInfo(std::move(mit->second));
+	rep_infos.erase(mit);
+
+	RepInfo& repInfo = rep_infos[rep];
+	repInfo.pointerCalls.insert(repInfo.pointerCalls.end(), mergedInfo.pointerCalls.begin(), mergedInfo.pointerCalls.end());
+	for (auto& group : mergedInfo.functions) {
+		set<Function*>& funcs = repInfo.functions[group.first];
+		// the smaller set is inserted into the larger one
+		if (funcs.size() < group.second.size()) {
+			funcs.swap(group.second);
+		}
+		funcs.insert(group.second.begin(), group.second.end());
+	}
+}
+
 void AAAnalyzer::handle_lib_invoke_call_inst(Value* ret, Function* f, vector<Value*>* args, DyckCallGraphNode* parent) {
     // args must be the real arguments, not the parameters.
     if (!f->empty() || f->isIntrinsic())
         return;
 
-    const string& functionName = f->getName().str();
-    switch (args->size()) {
-	case 1: {
-		if (functionName == "strdup" || functionName == "__strdup" || functionName == "strdupa") {
-			// content alias r/1st
-			this->makeContentAlias(wrapValue(args->at(0)), wrapValue(ret));
-		} else if (functionName == "pthread_getspecific" && ret) {
-			DyckVertex* keyRep = wrapValue(args->at(0));
-			DyckVertex* valRep = wrapValue(ret);
-			// we use label -1 to indicate that it is a key:value pair
-			keyRep->addTarget(valRep, aa->getOrInsertIndexEdgeLabel(-1));
-		}
-	}
-		break;
-	case 2: {
-		if (functionName == "strcat" || functionName == "strcpy") {
-			if (ret) {
-				DyckVertex * dst_ptr = wrapValue(args->at(0));
-				DyckVertex * src_ptr = wrapValue(args->at(1));
-
-				this->makeContentAlias(dst_ptr, src_ptr);
-				this->makeAlias(wrapValue(ret), dst_ptr);
-			} else {
-				errs() << "ERROR strcat/cpy does not return.\n";
-				exit(1);
-			}
-		} else if (functionName == "strndup" || functionName == "strndupa") {
-			// content alias r/1st
-			this->makeContentAlias(wrapValue(args->at(0)), wrapValue(ret));
-		} else if (functionName == "strstr" || functionName == "strcasestr") {
-			// content alias r/2nd
-			this->makeContentAlias(wrapValue(args->at(1)), wrapValue(ret));
-			// alias r/1st
-			this->makeAlias(wrapValue(ret), wrapValue(args->at(0)));
-		} else if (functionName == "strchr" || functionName == "strrchr" || functionName == "strchrnul" || functionName == "rawmemchr") {
-			// alias r/1st
-			this->makeAlias(wrapValue(ret), wrapValue(args->at(0)));
-		} else if (functionName == "strtok") {
-			// content alias r/1st
-			this->makeContentAlias(wrapValue(args->at(0)), wrapValue(ret));
-		} else if (functionName == "pthread_setspecific") {
-			DyckVertex* keyRep = wrapValue(args->at(0));
-			DyckVertex* valRep = wrapValue(args->at(1));
-			// we use label -1 to indicate that it is a key:value pair
-			keyRep->addTarget(valRep, aa->getOrInsertIndexEdgeLabel(-1));
-		}
-	}
-		break;
-	case 3: {
-		if (functionName == "strncat" || functionName == "strncpy" || functionName == "memcpy" || functionName == "memmove") {
-			if (ret) {
-				DyckVertex * dst_ptr = wrapValue(args->at(0));
-				DyckVertex * src_ptr = wrapValue(args->at(1));
-
-				this->makeContentAlias(dst_ptr, src_ptr);
-				this->makeAlias(wrapValue(ret), dst_ptr);
-			} else {
-				errs() << "ERROR strncat/cpy does not return.\n";
-				exit(1);
-			}
-		} else if (functionName == "memchr" || functionName == "memrchr" || functionName == "memset") {
-			// alias r/1st
-			this->makeAlias(wrapValue(ret), wrapValue(args->at(0)));
-		} else if (functionName == "strtok_r" || functionName == "__strtok_r") {
-			// content alias r/1st
-			this->makeContentAlias(wrapValue(args->at(0)), wrapValue(ret));
-		}
-	}
-		break;
-	case 4: {
-		if (functionName == "pthread_create") {
-			vector<Value*> xargs;
-			xargs.push_back(args->at(3));
-			DyckCallGraphNode* parent = callgraph->getOrInsertFunction(f);
-			this->handle_invoke_call_inst(nullptr, args->at(2), &xargs, parent);
-		}
-	}
-		break;
-	default:
-		break;
+    // the models of a function are looked up by its name only once
+    auto mit = lib_models.find(f);
+    if (mit == lib_models.end()) {
+        mit = lib_models.insert(std::make_pair(f, LibraryModels::get().lookup(f->getName()))).first;
+    }
+    const vector<LibraryEffect>* effects = mit->second;
+    if (effects == NULL) {
+        return;
+    }
+
+    int numArgs = args->size();
+    for (auto& effect : *effects) {
+        if (effect.numArgs != LibraryEffect::AnyArgs && effect.numArgs != numArgs) {
+            continue;
+        }
+        if (effect.first >= numArgs || effect.second >= numArgs) {
+            continue;
+        }
+
+        Value* first = effect.first == LibraryEffect::Ret ? ret : args->at(effect.first);
+        Value* second = effect.second == LibraryEffect::Ret ? ret : args->at(effect.second);
+        if (first == NULL || second == NULL) {
+            // an implicit call has no return value
+            continue;
+        }
+
+        switch (effect.kind) {
+        case LibraryEffect::ALIAS:
+            this->makeAlias(wrapValue(first), wrapValue(second));
+            break;
+        case LibraryEffect::CONTENT_ALIAS:
+            this->makeContentAlias(wrapValue(first), wrapValue(second));
+            break;
+        case LibraryEffect::KEY_VALUE: {
+            DyckVertex* keyRep = wrapValue(first);
+            DyckVertex* valRep = wrapValue(second);
+            // we use label -1 to indicate that it is a key:value pair
+            keyRep->addTarget(valRep, aa->getOrInsertIndexEdgeLabel(-1));
+        }
+            break;
+        case LibraryEffect::THREAD_SPAWN:
+            if (owner) {
+                // the node of the function is shared by the functions
+                deferred_implicit_calls.push_back(std::make_tuple(f, first, second));
+            } else {
+                vector<Value*> xargs;
+                xargs.push_back(second);
+                DyckCallGraphNode* parent = callgraph->getOrInsertFunction(f);
+                this->handle_invoke_call_inst(nullptr, first, &xargs, parent);
+            }
+            break;
+        case LibraryEffect::READONLY_ARG:
+            break;
+        }
     }
 }
@@ -5,18 +5,26 @@
 
 #define DEBUG_TYPE "dyckaa"
 #include "DyckAA/DyckAliasAnalysis.h"
+#include "DyckAA/DyckResultCache.h"
+#include "DyckAA/DyckSnapshot.h"
+#include "DyckGraph/DyckGraphExporter.h"
 #include "DyckCG/DyckCallGraph.h"
 
 #include <stdio.h>
 #include <algorithm>
+#include <functional>
 #include <stack>
 
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Process.h"
 
 static cl::opt<bool> PrintAliasSetInformation("print-alias-set-info", cl::init(false), cl::Hidden,
 		cl::desc("Output all alias sets, their relations and the evaluation results."));
 
+static cl::opt<bool> PrintAliasQueries("print-alias-queries", cl::init(false), cl::Hidden,
+		cl::desc("Output the results of alias() for the pairs of the pointers in each function into alias_queries.log."));
+
 static cl::opt<bool> PreserveCallGraph("preserve-dyck-callgraph", cl::init(false), cl::Hidden,
 		cl::desc("Preserve the call graph for usage in other passes."));
 
@@ -27,6 +35,57 @@ static cl::opt<bool> CountFP("count-fp", cl::init(false), cl::Hidden, cl::desc("
 
 static cl::opt<bool> IntraProcedure("intra", cl::init(false), cl::Hidden, cl::desc("Only run for intra_procedure."));
 
+static cl::opt<std::string> SnapshotOutput("dyckaa-save-snapshot", cl::init(""), cl::Hidden,
+		cl::desc("Save the result of the alias analysis into a snapshot file."));
+
+static cl::opt<std::string> SnapshotInput("dyckaa-load-snapshot", cl::init(""), cl::Hidden,
+		cl::desc("Load the result of the alias analysis from a snapshot file instead of analyzing the module. "
+				"The module is analyzed if the snapshot does not match it."));
+
+static cl::opt<std::string> ResultCache("dyckaa-result-cache", cl::init(""), cl::Hidden,
+		cl::desc("A directory where the results of the alias analysis are cached by the hashes of the modules."));
+
+static cl::opt<unsigned> ResultCacheSize("dyckaa-result-cache-size", cl::init(1024), cl::Hidden,
+		cl::desc("The max size in MB of -dyckaa-result-cache, the least recently used results are removed."));
+
+static cl::opt<std::string> ResultCacheSeed("dyckaa-result-cache-seed", cl::init(""), cl::Hidden,
+		cl::desc("A read-only directory of cached results, e.g. filled by CI, which is looked up if a result is not in -dyckaa-result-cache."));
+
+static cl::opt<std::string> ExportGraph("dyckaa-export", cl::init(""), cl::Hidden,
+		cl::desc("Export the alias sets and the relations among them into a file."));
+
+static cl::opt<DyckGraphExporter::Format> ExportFormat("dyckaa-export-format", cl::init(DyckGraphExporter::DOT), cl::Hidden,
+		cl::desc("The format of the file of -dyckaa-export."),
+		cl::values(clEnumValN(DyckGraphExporter::DOT, "dot", "graphviz"),
+				clEnumValN(DyckGraphExporter::EDGE_LIST, "edges", "a binary edge list"),
+				clEnumValN(DyckGraphExporter::GRAPHML, "graphml", "GraphML"),
+				clEnumValEnd));
+
+static cl::opt<bool> CompactGraph("dyckaa-compact", cl::init(true), cl::Hidden,
+		cl::desc("Drop the data only used by the analysis and renumber the graph for queries when the analysis is done."));
+
+static cl::opt<DyckWorkList::Order> MergeOrder("dyckaa-merge-order", cl::init(DyckWorkList::FIFO), cl::Hidden,
+		cl::desc("The order in which the vertices of the dyck graph are merged."),
+		cl::values(clEnumValN(DyckWorkList::FIFO, "fifo", "first in, first out"),
+				clEnumValN(DyckWorkList::HIGHEST_DEGREE, "degree", "vertices of higher degrees first"),
+				clEnumValN(DyckWorkList::LABEL_PRIORITY, "label", "dereferences before fields and offsets"),
+				clEnumValEnd));
+
+static const char* MergeOrderNames[] = { "fifo", "degree", "label" };
+
+static cl::list<std::string> ExtraMemAllocas("dyckaa-mem-alloca", cl::ZeroOrMore, cl::CommaSeparated, cl::Hidden,
+		cl::desc("The functions that allocate memory like malloc, e.g. -dyckaa-mem-alloca=slabs_alloc,xmalloc."));
+
+static cl::list<std::string> RegionFunctions("dyckaa-region", cl::ZeroOrMore, cl::CommaSeparated, cl::Hidden,
+		cl::desc("Only analyze the functions that the given ones depend on, e.g. -dyckaa-region=main,worker. "
+				"MayAlias is returned for a value whose result may differ from the one of the whole analysis."));
+
+static cl::opt<unsigned> NumThreads("dyckaa-threads", cl::init(1), cl::Hidden,
+		cl::desc("The number of threads used to normalize the dyck graph."));
+
+static cl::opt<unsigned> MinParallelObligations("dyckaa-min-parallel-obligations", cl::init(1024), cl::Hidden,
+		cl::desc("The fewest pairs of vertices to merge that are normalized with -dyckaa-threads."));
+
 static const Function *getParent(const Value *V) {
 	if (const Instruction * inst = dyn_cast<Instruction>(V))
 		return inst->getParent()->getParent();
@@ -49,29 +108,16 @@ DyckAliasAnalysis::DyckAliasAnalysis() :
 		ModulePass(ID) {
 	dyck_graph = new DyckGraph;
 	call_graph = new DyckCallGraph;
+	offset_reach = NULL;
 
-	DEREF_LABEL = new DerefEdgeLabel;
+	DEREF_LABEL = EdgeLabel::getDerefLabel();
 }
 
 DyckAliasAnalysis::~DyckAliasAnalysis() {
+	delete offset_reach;
 	delete call_graph;
 	delete dyck_graph;
 
-	// delete edge labels
-	delete DEREF_LABEL;
-
-	auto olIt = OFFSET_LABEL_MAP.begin();
-	while (olIt != OFFSET_LABEL_MAP.end()) {
-		delete olIt->second;
-		olIt++;
-	}
-
-	auto ilIt = INDEX_LABEL_MAP.begin();
-	while (ilIt != INDEX_LABEL_MAP.end()) {
-		delete ilIt->second;
-		ilIt++;
-	}
-
 	for (auto& it : vertexMemAllocaMap) {
 	    delete it.second;
 	}
@@ -103,6 +149,11 @@ DyckAliasAnalysis::AliasResult DyckAliasAnalysis::alias(const Location &LocA, co
 		return ret;
 	}
 
+	if (!isSolved(LocA.Ptr) || !isSolved(LocB.Ptr)) {
+		// out of the region of -dyckaa-region
+		return ret;
+	}
+
 	pair<DyckVertex*, bool> retpair = dyck_graph->retrieveDyckVertex(const_cast<Value*>(LocA.Ptr));
 	DyckVertex * VA = retpair.first;
 
@@ -173,6 +224,22 @@ bool DyckAliasAnalysis::isPartialAlias(DyckVertex *v1, DyckVertex * v2) {
 	if (v1 == v2)
 		return false;
 
+	DyckCSR* csr = dyck_graph->getCSR();
+	if (csr != NULL) {
+		unsigned id1 = csr->getId(v1);
+		unsigned id2 = csr->getId(v2);
+		if (id1 == DyckCSR::InvalidId || id2 == DyckCSR::InvalidId) {
+			// vertices created after the analysis have no edges
+			return false;
+		}
+
+		if (offset_reach == NULL || offset_reach->getCSR() != csr) {
+			// the graph has been frozen again
+			buildOffsetReachability();
+		}
+		return offset_reach->reachable(id1, id2);
+	}
+
 	set<DyckVertex*> visited;
 	stack<DyckVertex*> workStack;
 	workStack.push(v1);
@@ -193,14 +260,13 @@ bool DyckAliasAnalysis::isPartialAlias(DyckVertex *v1, DyckVertex * v2) {
 		visited.insert(top);
 
 		{ // push out tars
-			set<void*>& outlabels = top->getOutLabels();
-			set<void*>::iterator olIt = outlabels.begin();
-			while (olIt != outlabels.end()) {
-				EdgeLabel* labelValue = (EdgeLabel*) (*olIt);
-				if (labelValue->isLabelTy(EdgeLabel::OFFSET_TYPE)) {
-					set<DyckVertex*>* tars = top->getOutVertices(*olIt);
-
-					set<DyckVertex*>::iterator tit = tars->begin();
+			DyckEdgeMap& outs = top->getOutVertices();
+			DyckEdgeMap::iterator olIt = outs.begin();
+			while (olIt != outs.end()) {
+				if (EdgeLabel::isLabelTy(olIt->first, EdgeLabel::OFFSET_TYPE)) {
+					DyckVertexSet* tars = &olIt->second;
+
+					DyckVertexSet::iterator tit = tars->begin();
 					while (tit != tars->end()) {
 						// if it has not been visited
 						if (visited.find(*tit) == visited.end()) {
@@ -218,9 +284,28 @@ bool DyckAliasAnalysis::isPartialAlias(DyckVertex *v1, DyckVertex * v2) {
 	return false;
 }
 
+void DyckAliasAnalysis::buildOffsetReachability() {
+	DyckCSR* csr = dyck_graph->getCSR();
+	assert(csr != NULL);
+
+	vector<bool> offsetLabels(dyck_graph->numLabels(), false);
+	for (unsigned i = 0; i < offsetLabels.size(); i++) {
+		offsetLabels[i] = EdgeLabel::isLabelTy(dyck_graph->getLabel(i), EdgeLabel::OFFSET_TYPE);
+	}
+
+	delete offset_reach;
+	offset_reach = new DyckReachability(csr, offsetLabels);
+}
+
 void DyckAliasAnalysis::getEscapedPointersFrom(std::vector<const set<Value*>*>* ret, Value * from) {
 	assert(ret != NULL);
 
+	if (!isSolved(from)) {
+		// out of the region of -dyckaa-region, any set may escape
+		getAllSets(ret);
+		return;
+	}
+
 	set<DyckVertex*> temp;
 	getEscapedPointersFrom(&temp, from);
 
@@ -239,38 +324,24 @@ void DyckAliasAnalysis::getEscapedPointersFrom(set<DyckVertex*>* ret, Value * fr
 		assert(!((Argument* ) from)->getParent()->empty());
 	}
 
-	set<DyckVertex*>& visited = *ret;
+	assert(isSolved(from));
+
 	stack<DyckVertex*> workStack;
 
 	workStack.push(dyck_graph->retrieveDyckVertex(from).first);
 
-	while (!workStack.empty()) {
-		DyckVertex* top = workStack.top();
-		workStack.pop();
-
-		// have visited
-		if (visited.find(top) != visited.end()) {
-			continue;
-		}
-
-		visited.insert(top);
-
-		set<DyckVertex*> tars;
-		top->getOutVertices(&tars);
-		set<DyckVertex*>::iterator tit = tars.begin();
-		while (tit != tars.end()) {
-			// if it has not been visited
-			if (visited.find(*tit) == visited.end()) {
-				workStack.push(*tit);
-			}
-			tit++;
-		}
-	}
+	getReachableVertices(ret, workStack);
 }
 
 void DyckAliasAnalysis::getEscapedPointersTo(std::vector<const set<Value*>*>* ret, Function * func) {
 	assert(ret != NULL);
 
+	if (!region_funcs.empty()) {
+		// the roots are the globals and the call sites of the whole module, so any set may escape
+		getAllSets(ret);
+		return;
+	}
+
 	set<DyckVertex*> temp;
 	getEscapedPointersTo(&temp, func);
 
@@ -282,48 +353,140 @@ void DyckAliasAnalysis::getEscapedPointersTo(std::vector<const set<Value*>*>* re
 	}
 }
 
+void DyckAliasAnalysis::indexEscapeRoots(Module& M) {
+	global_escape_roots.clear();
+	iplist<GlobalVariable>::iterator git = M.global_begin();
+	while (git != M.global_end()) {
+		if (!git->hasPrivateLinkage() && !git->getName().startswith("llvm.") && git->getName().str() != "stderr"
+				&& git->getName().str() != "stdout") { // in fact, no such symbols in src codes.
+			global_escape_roots.push_back(dyck_graph->retrieveDyckVertex(git).first);
+		}
+		git++;
+	}
+
+	// the call sites of a function are the common calls of it and
+	// the pointer calls that may call it
+	call_escape_roots.clear();
+	auto addRoots = [this](Call* call, Function* callee) {
+		if (call->instruction == NULL) {
+			// implicit calls, e.g. the ones in pthread_create, have no call sites
+			return;
+		}
+
+		vector<DyckVertex*>& roots = call_escape_roots[callee];
+		if (callee->hasName() && callee->getName() == "pthread_create") {
+			roots.push_back(dyck_graph->retrieveDyckVertex(call->args[3]).first);
+		} else {
+			for (auto arg : call->args) {
+				roots.push_back(dyck_graph->retrieveDyckVertex(arg).first);
+			}
+		}
+	};
+
+	// A pointer call may call each function in the class of its called value, even
+	// if the function is not one of its callees, e.g. the type of the function does
+	// not match the call or the callees are not resolved with -intra.
+	map<DyckVertex*, vector<Function*> > repFunctions;
+	for (auto& F : M) {
+		if (DyckVertex* rep = dyck_graph->findDyckVertex(&F)) {
+			repFunctions[rep].push_back(&F);
+		}
+	}
+
+	for (auto& it : *call_graph) {
+		for (auto call : it.second->getCommonCalls()) {
+			addRoots(call, (Function*) call->calledValue);
+		}
+		for (auto call : it.second->getPointerCalls()) {
+			for (auto callee : call->mayAliasedCallees) {
+				addRoots(call, callee);
+			}
+
+			auto fit = repFunctions.find(dyck_graph->findDyckVertex(call->calledValue));
+			if (fit != repFunctions.end()) {
+				for (auto callee : fit->second) {
+					addRoots(call, callee);
+				}
+			}
+		}
+	}
+
+	for (auto& it : call_escape_roots) {
+		vector<DyckVertex*>& roots = it.second;
+		std::sort(roots.begin(), roots.end());
+		roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+	}
+
+	escaped_to_cache.clear();
+}
+
 void DyckAliasAnalysis::getEscapedPointersTo(set<DyckVertex*>* ret, Function * func) {
 	assert(ret != NULL);
 	assert(func != NULL);
 
-	Module* module = func->getParent();
+	assert(region_funcs.empty());
 
-	set<DyckVertex*>& visited = *ret;
-	stack<DyckVertex*> workStack;
+	auto cit = escaped_to_cache.find(func);
+	if (cit == escaped_to_cache.end()) {
+		stack<DyckVertex*> workStack;
+		for (auto root : global_escape_roots) {
+			workStack.push(root);
+		}
 
-	iplist<GlobalVariable>::iterator git = module->global_begin();
-	while (git != module->global_end()) {
-		if (!git->hasPrivateLinkage() && !git->getName().startswith("llvm.") && git->getName().str() != "stderr"
-				&& git->getName().str() != "stdout") { // in fact, no such symbols in src codes.
-			DyckVertex * rt = dyck_graph->retrieveDyckVertex(git).first;
-			workStack.push(rt);
+		auto rit = call_escape_roots.find(func);
+		if (rit != call_escape_roots.end()) {
+			for (auto root : rit->second) {
+				workStack.push(root);
+			}
 		}
-		git++;
+
+		cit = escaped_to_cache.insert(make_pair(func, set<DyckVertex*>())).first;
+		getReachableVertices(&cit->second, workStack);
 	}
 
-	for (ilist_iterator<Function> iterF = module->getFunctionList().begin(); iterF != module->getFunctionList().end(); iterF++) {
-		Function* f = iterF;
-		for (ilist_iterator<BasicBlock> iterB = f->getBasicBlockList().begin(); iterB != f->getBasicBlockList().end(); iterB++) {
-			for (ilist_iterator<Instruction> iterI = iterB->getInstList().begin(); iterI != iterB->getInstList().end(); iterI++) {
-				Instruction *rawInst = iterI;
-				if (isa<CallInst>(rawInst)) {
-					CallInst *inst = (CallInst*) rawInst; // all invokes are lowered to call
-					AliasResult ar = this->alias(func, inst->getCalledValue());
-					if (ar == MayAlias || ar == MustAlias) {
-						if (func->hasName() && func->getName() == "pthread_create") {
-							DyckVertex * rt = dyck_graph->retrieveDyckVertex(inst->getArgOperand(3)).first;
-							workStack.push(rt);
-						} else {
-							unsigned num = inst->getNumArgOperands();
-							for (unsigned i = 0; i < num; i++) {
-								DyckVertex * rt = dyck_graph->retrieveDyckVertex(inst->getArgOperand(i)).first;
-								workStack.push(rt);
-							}
-						}
-					}
+	ret->insert(cit->second.begin(), cit->second.end());
+}
+
+void DyckAliasAnalysis::getReachableVertices(set<DyckVertex*>* ret, stack<DyckVertex*>& workStack) {
+	set<DyckVertex*>& visited = *ret;
+
+	DyckCSR* csr = dyck_graph->getCSR();
+	if (csr != NULL) {
+		vector<bool> visitedIds(csr->numVertices(), false);
+		stack<unsigned> idStack;
+		while (!workStack.empty()) {
+			DyckVertex* top = workStack.top();
+			workStack.pop();
+
+			unsigned id = csr->getId(top);
+			if (id == DyckCSR::InvalidId) {
+				// vertices created after the analysis have no edges
+				visited.insert(top);
+			} else {
+				idStack.push(id);
+			}
+		}
+
+		while (!idStack.empty()) {
+			unsigned top = idStack.top();
+			idStack.pop();
+
+			// have visited
+			if (visitedIds[top]) {
+				continue;
+			}
+
+			visitedIds[top] = true;
+			visited.insert(csr->getVertex(top));
+
+			for (unsigned e = csr->outBegin(top); e != csr->outEnd(top); e++) {
+				// if it has not been visited
+				if (!visitedIds[csr->outTarget(e)]) {
+					idStack.push(csr->outTarget(e));
 				}
 			}
 		}
+		return;
 	}
 
 	while (!workStack.empty()) {
@@ -337,16 +500,17 @@ void DyckAliasAnalysis::getEscapedPointersTo(set<DyckVertex*>* ret, Function * f
 
 		visited.insert(top);
 
-		set<DyckVertex*> tars;
-		top->getOutVertices(&tars);
-		set<DyckVertex*>::iterator tit = tars.begin();
-		while (tit != tars.end()) {
-			// if it has not been visited
-			DyckVertex* dv = (*tit);
-			if (visited.find(dv) == visited.end()) {
-				workStack.push(dv);
+		DyckEdgeMap& outs = top->getOutVertices();
+		for (auto& out : outs) {
+			DyckVertexSet::iterator tit = out.second.begin();
+			while (tit != out.second.end()) {
+				// if it has not been visited
+				DyckVertex* dv = (*tit);
+				if (visited.find(dv) == visited.end()) {
+					workStack.push(dv);
+				}
+				tit++;
 			}
-			tit++;
 		}
 	}
 }
@@ -354,12 +518,20 @@ void DyckAliasAnalysis::getEscapedPointersTo(set<DyckVertex*>* ret, Function * f
 void DyckAliasAnalysis::getPointstoObjects(std::set<Value*>& objects, Value* pointer) {
 	assert(pointer != nullptr);
 
+	if (!isSolved(pointer)) {
+		// out of the region of -dyckaa-region, it may point to any value
+		vector<const set<Value*>*> sets;
+		getAllSets(&sets);
+		for (auto vals : sets) {
+			objects.insert(vals->begin(), vals->end());
+		}
+		return;
+	}
+
 	DyckVertex * rt = dyck_graph->retrieveDyckVertex(pointer).first;
-	auto tars = rt->getOutVertices(DEREF_LABEL);
-	if (tars != nullptr && !tars->empty()) {
-		assert(tars->size() == 1);
-		set<DyckVertex*>::iterator tit = tars->begin();
-		DyckVertex* tar = (*tit);
+	DyckVertex* tar = rt->getOutVertex(DEREF_LABEL);
+	if (tar != nullptr) {
+		assert(rt->outNumVertices(DEREF_LABEL) == 1);
 		auto vals = tar->getEquivalentSet();
 		for (auto& val : *vals) {
 			objects.insert((Value*) val);
@@ -369,48 +541,77 @@ void DyckAliasAnalysis::getPointstoObjects(std::set<Value*>& objects, Value* poi
 
 bool DyckAliasAnalysis::isDefaultMemAllocaFunction(Value* calledValue) {
     if (isa<Function>(calledValue)) {
-        if(mem_allocas.count((Function*)calledValue)){
-            return true;
-        }
-    } else {
-        for (auto& func : mem_allocas) {
-            if (this->alias(calledValue, func)) {
-                return true;
-            }
-        }
+        return mem_allocas.count((Function*) calledValue);
     }
 
-    return false;
-}
-
-std::vector<Value*>* DyckAliasAnalysis::getDefaultPointstoMemAlloca(Value* ptr) {
-    assert(ptr->getType()->isPointerTy());
-
-    DyckVertex* v = dyck_graph->retrieveDyckVertex(ptr).first;
-    if (vertexMemAllocaMap.count(v)) {
-        return vertexMemAllocaMap[v];
+    if (!region_funcs.empty()) {
+        // mem_alloca_reps is not built for a region, and any called value may be an allocator
+        return true;
     }
 
-    std::vector<Value*>* objects = new std::vector<Value*>;
-    vertexMemAllocaMap[v] = objects;
-
-    // find allocas in v self
-    auto aliases = (const set<Value*>*) v->getEquivalentSet();
+    // a called value aliases an allocator iff they are in the same equivalent set
+    DyckVertex* v = dyck_graph->findDyckVertex(calledValue);
+    return v != NULL && mem_alloca_reps.count(v);
+}
 
+void DyckAliasAnalysis::collectMemAllocas(const set<Value*>* aliases, std::vector<Value*>& objects) {
     for (auto& al : *aliases) {
         if (isa<GlobalVariable>(al) || isa<Function>(al)) {
-            objects->push_back(al);
+            objects.push_back(al);
         } else if (isa<AllocaInst>(al)) {
-            objects->push_back(al);
+            objects.push_back(al);
         } else if (isa<CallInst>(al) || isa<InvokeInst>(al)) {
             CallSite cs(al);
             Value* calledValue = cs.getCalledValue();
             if (isDefaultMemAllocaFunction(calledValue)) {
-                objects->push_back(al);
+                objects.push_back(al);
             }
         }
     }
+}
+
+void DyckAliasAnalysis::indexMemAllocas() {
+    mem_alloca_reps.clear();
+    for (auto func : mem_allocas) {
+        DyckVertex* v = dyck_graph->findDyckVertex(func);
+        if (v != NULL) {
+            mem_alloca_reps.insert(v);
+        }
+    }
+
+    DyckCSR* csr = dyck_graph->getCSR();
+    csr_mem_allocas.clear();
+    csr_mem_allocas.resize(csr->numVertices());
+    for (unsigned id = 0; id < csr->numVertices(); id++) {
+        collectMemAllocas((const set<Value*>*) csr->getVertex(id)->getEquivalentSet(), csr_mem_allocas[id]);
+    }
+}
+
+std::vector<Value*>* DyckAliasAnalysis::getDefaultPointstoMemAlloca(Value* ptr) {
+    assert(ptr->getType()->isPointerTy());
+
+    if (!isSolved(ptr)) {
+        // out of the region of -dyckaa-region, it may point to any allocation site
+        return &region_mem_allocas;
+    }
+
+    DyckVertex* v = dyck_graph->retrieveDyckVertex(ptr).first;
+    DyckCSR* csr = dyck_graph->getCSR();
+    if (csr != NULL && csr->numVertices() == csr_mem_allocas.size()) {
+        unsigned id = csr->getId(v);
+        if (id != DyckCSR::InvalidId) {
+            return &csr_mem_allocas[id];
+        }
+    }
+
+    // vertices created after the analysis
+    if (vertexMemAllocaMap.count(v)) {
+        return vertexMemAllocaMap[v];
+    }
 
+    std::vector<Value*>* objects = new std::vector<Value*>;
+    vertexMemAllocaMap[v] = objects;
+    collectMemAllocas((const set<Value*>*) v->getEquivalentSet(), *objects);
     return objects;
 }
 
@@ -425,6 +626,8 @@ DyckCallGraph* DyckAliasAnalysis::getCallGraph() {
 
 bool DyckAliasAnalysis::runOnModule(Module & M) {
 	InitializeAliasAnalysis(this);
+	dyck_graph->setNumThreads(NumThreads, MinParallelObligations);
+	dyck_graph->setMergeOrder(MergeOrder);
 
 	{
 	   auto addAllocLikeFunc = [this, &M](const char* name) {
@@ -447,27 +650,94 @@ bool DyckAliasAnalysis::runOnModule(Module & M) {
 	   addAllocLikeFunc("_ZnwjRKSt9nothrow_t");
 	   addAllocLikeFunc("_Znwm");
 	   addAllocLikeFunc("_ZnwmRKSt9nothrow_t");
+	   for (auto& name : ExtraMemAllocas) {
+	       addAllocLikeFunc(name.c_str());
+	   }
 	}
 
-	AAAnalyzer* aaa = new AAAnalyzer(&M, this, dyck_graph, call_graph);
+	bool loaded = false;
+	if (!SnapshotInput.empty()) {
+		loaded = DyckSnapshot::load(SnapshotInput.c_str(), M, dyck_graph, call_graph, edge_labels);
+		if (!loaded) {
+			errs() << "[Canary] The snapshot " << SnapshotInput << " cannot be loaded, the module is analyzed.\n";
+		}
+	}
 
-	/// step 1: intra-procedure analysis
-	aaa->start_intra_procedure_analysis();
-	//outs() << "Start intra-procedure analysis...\n";
-	aaa->intra_procedure_analysis();
-	//outs() << "Done!\n\n";
-	aaa->end_intra_procedure_analysis();
+	DyckResultCache* resultCache = NULL;
+	if (!loaded && (!ResultCache.empty() || !ResultCacheSeed.empty())) {
+		MD5 options;
+		AAAnalyzer::hashOptions(options);
+		uint8_t intraOnly = IntraProcedure;
+		options.update(ArrayRef<uint8_t>(&intraOnly, 1));
 
-    if (!IntraProcedure){
-        /// step 2: inter-procedure analysis
-        aaa->start_inter_procedure_analysis();
-        //outs() << "Start inter-procedure analysis...";
-        aaa->inter_procedure_analysis();
-        //outs() << "\nDone!\n\n";
-        aaa->end_inter_procedure_analysis();
-    }
+		resultCache = new DyckResultCache(ResultCache, ResultCacheSeed, (uint64_t) ResultCacheSize << 20, M, options);
+		loaded = resultCache->load(M, dyck_graph, call_graph, edge_labels);
+		DEBUG_WITH_TYPE("dyckaa-stats", outs() << "Result cache: " << (loaded ? "hit " : "miss ") << resultCache->getKey() << "\n");
+	}
+
+	// a loaded result is the one of the whole analysis
+	if (!loaded && !RegionFunctions.empty()) {
+		const char* conflict = NULL;
+		if (PrintAliasSetInformation) {
+			conflict = PrintAliasSetInformation.ArgStr;
+		} else if (PreserveCallGraph) {
+			conflict = PreserveCallGraph.ArgStr;
+		} else if (DotCallGraph) {
+			conflict = DotCallGraph.ArgStr;
+		} else if (CountFP) {
+			conflict = CountFP.ArgStr;
+		} else if (!SnapshotOutput.empty()) {
+			conflict = SnapshotOutput.ArgStr;
+		} else if (!ExportGraph.empty()) {
+			conflict = ExportGraph.ArgStr;
+		} else if (!AAAnalyzer::supportsRegion()) {
+			conflict = "-with-function-cast-comb or -dyckaa-inter-iteration";
+		}
+		if (conflict) {
+			// the options are checked before the analysis, rather than ignoring the region
+			errs() << "[Canary] -dyckaa-region cannot be used with " << (conflict[0] == '-' ? "" : "-") << conflict
+					<< ", which needs the result of the whole analysis.\n";
+			exit(1);
+		}
+		computeRegion(M);
+	}
+
+	analyze(M, loaded, resultCache);
+
+	delete resultCache;
+	resultCache = NULL;
+
+	return false;
+}
+
+void DyckAliasAnalysis::analyze(Module& M, bool loaded, DyckResultCache* resultCache) {
+	if (!loaded) {
+		AAAnalyzer* aaa = new AAAnalyzer(&M, this, dyck_graph, call_graph);
+		if (!region_funcs.empty()) {
+			aaa->setRegion(&region_funcs);
+		}
+
+		/// step 1: intra-procedure analysis
+		aaa->start_intra_procedure_analysis();
+		//outs() << "Start intra-procedure analysis...\n";
+		aaa->intra_procedure_analysis();
+		//outs() << "Done!\n\n";
+		aaa->end_intra_procedure_analysis();
+
+	    if (!IntraProcedure){
+	        /// step 2: inter-procedure analysis
+	        aaa->start_inter_procedure_analysis();
+	        //outs() << "Start inter-procedure analysis...";
+	        aaa->inter_procedure_analysis();
+	        //outs() << "\nDone!\n\n";
+	        aaa->end_inter_procedure_analysis();
+	    }
+
+		delete aaa;
+		aaa = NULL;
+	}
 
-	/* call graph */
+	/* call graph, which is also the one loaded with the result */
 	if (DotCallGraph) {
 		outs() << "Printing call graph...\n";
 		call_graph->dotCallGraph(M.getModuleIdentifier());
@@ -480,8 +750,40 @@ bool DyckAliasAnalysis::runOnModule(Module & M) {
 		outs() << "Done!\n\n";
 	}
 
-	delete aaa;
-	aaa = NULL;
+	// queries only read the graph from now on
+	dyck_graph->freeze();
+	DEBUG_WITH_TYPE("dyckaa-stats", dyck_graph->printMemoryUsage());
+	DEBUG_WITH_TYPE("dyckaa-stats",
+			outs() << "Merges: " << dyck_graph->getNumMerges() << ", edges moved: " << dyck_graph->getNumEdgesMoved()
+					<< " (-dyckaa-merge-order=" << MergeOrderNames[MergeOrder] << ")\n");
+
+	if (!SnapshotOutput.empty() && !DyckSnapshot::save(SnapshotOutput.c_str(), M, dyck_graph, call_graph, edge_labels)) {
+		errs() << "[Canary] The snapshot " << SnapshotOutput << " cannot be saved.\n";
+	}
+
+	// the result of a region is not cached
+	if (resultCache && resultCache->needsSaving() && region_funcs.empty()
+			&& !resultCache->save(M, dyck_graph, call_graph, edge_labels)) {
+		errs() << "[Canary] The result cannot be saved into the cache " << ResultCache << ".\n";
+	}
+
+	if (!ExportGraph.empty()) {
+		DyckGraphExporter exporter(dyck_graph);
+		exporter.setNumThreads(NumThreads);
+		exporter.setLabelDescription([this](void* label) {
+			return edge_labels.getDescription(label);
+		});
+		if (!exporter.write(ExportGraph.c_str(), ExportFormat)) {
+			errs() << "[Canary] The graph cannot be exported to " << ExportGraph << ".\n";
+		}
+	}
+
+	if (region_funcs.empty()) {
+		// the call sites are needed by getEscapedPointersTo() after the call graph is released
+		indexEscapeRoots(M);
+	} else {
+		collectRegionSeeds();
+	}
 
 	if (!this->callGraphPreserved()) {
 		delete this->call_graph;
@@ -496,13 +798,388 @@ bool DyckAliasAnalysis::runOnModule(Module & M) {
 
 	DEBUG_WITH_TYPE("validate-dyckgraph", dyck_graph->validation(__FILE__, __LINE__));
 
-	return false;
+	if (CompactGraph) {
+		unsigned long graphBefore = dyck_graph->getMemoryUsage();
+		size_t heapBefore = sys::Process::GetMallocUsage();
+		dyck_graph->compact();
+		DEBUG_WITH_TYPE("dyckaa-stats",
+				outs() << "Compaction: graph " << graphBefore / 1024 << " KB -> " << dyck_graph->getMemoryUsage() / 1024
+						<< " KB, heap " << heapBefore / 1024 << " KB -> " << sys::Process::GetMallocUsage() / 1024 << " KB\n");
+	}
+
+	// compact() renumbers the CSR, so the reachability is built at last
+	buildOffsetReachability();
+	DEBUG_WITH_TYPE("dyckaa-stats", outs() << "Offset reachability: " << offset_reach->numComponents() << " components\n");
+	if (region_funcs.empty()) {
+		indexMemAllocas();
+	} else {
+		indexRegionStability();
+		indexRegionRest(M);
+	}
+
+	if (PrintAliasQueries) {
+		outs() << "Printing alias_queries.log... ";
+		outs().flush();
+		this->printAliasQueries(M);
+		outs() << "Done!\n";
+	}
+}
+
+void DyckAliasAnalysis::computeRegion(Module& M) {
+	region_funcs.clear();
+	region_boundary.clear();
+
+	vector<Function*> funcList;
+	for (auto& name : RegionFunctions) {
+		Function* F = M.getFunction(name);
+		if (F == NULL || F->empty()) {
+			errs() << "[Canary] " << name << " of -dyckaa-region is not a function with a body, it is ignored.\n";
+		} else if (region_funcs.insert(F).second) {
+			funcList.push_back(F);
+		}
+	}
+
+	// the constants used in the region, including the initializers and the aliasees of
+	// the global values, which are analyzed with them
+	set<Constant*> used;
+	vector<Constant*> constList;
+	auto use = [&used, &constList](Value* v) {
+		if (Constant* c = dyn_cast<Constant>(v)) {
+			if (used.insert(c).second) {
+				constList.push_back(c);
+			}
+		}
+	};
+
+	while (!funcList.empty() || !constList.empty()) {
+		if (!funcList.empty()) {
+			Function* F = funcList.back();
+			funcList.pop_back();
+			for (auto& B : *F) {
+				for (auto& I : B) {
+					for (auto& op : I.operands()) {
+						use(op);
+					}
+				}
+			}
+			continue;
+		}
+
+		Constant* c = constList.back();
+		constList.pop_back();
+		if (Function* F = dyn_cast<Function>(c)) {
+			// the function is bound to its calls and the pointer calls of its address
+			if (!F->empty() && region_funcs.insert(F).second) {
+				funcList.push_back(F);
+			}
+		} else if (GlobalVariable* gv = dyn_cast<GlobalVariable>(c)) {
+			if (gv->hasInitializer()) {
+				use(gv->getInitializer());
+			}
+		} else if (GlobalAlias* ga = dyn_cast<GlobalAlias>(c)) {
+			use(ga->getAliasee());
+		} else {
+			for (auto& op : c->operands()) {
+				use(op);
+			}
+		}
+	}
+
+	// A constant used out of the region, e.g. a global or a null pointer, shares its
+	// vertex with the functions out of the region in the whole analysis. A constant
+	// that only constant expressions use is used out of the region if they are.
+	map<Constant*, bool> usedOutside;
+	std::function<bool(Constant*)> isUsedOutside = [&](Constant* c) {
+		auto it = usedOutside.find(c);
+		if (it != usedOutside.end()) {
+			return it->second;
+		}
+
+		bool ret = false;
+		for (auto user : c->users()) {
+			if (Instruction* inst = dyn_cast<Instruction>(user)) {
+				ret = !region_funcs.count(inst->getParent()->getParent());
+			} else if (GlobalValue* gv = dyn_cast<GlobalValue>(user)) {
+				ret = !used.count(gv);
+			} else if (Constant* uc = dyn_cast<Constant>(user)) {
+				ret = isUsedOutside(uc);
+			}
+			if (ret) {
+				break;
+			}
+		}
+		usedOutside[c] = ret;
+		return ret;
+	};
+
+	for (auto c : used) {
+		if (isUsedOutside(c)) {
+			region_boundary.push_back(c);
+		}
+	}
+	for (auto F : region_funcs) {
+		if (!used.count(F) && isUsedOutside(F)) {
+			region_boundary.push_back(F);
+		}
+	}
+
+	unsigned numFuncs = 0;
+	for (auto& F : M) {
+		numFuncs += !F.empty();
+	}
+	DEBUG_WITH_TYPE("dyckaa-stats", outs() << "Region: " << region_funcs.size() << " of " << numFuncs << " functions, "
+			<< region_boundary.size() << " of " << used.size() << " constants on the boundary\n");
+}
+
+void DyckAliasAnalysis::collectRegionSeeds() {
+	set<Value*> boundary(region_boundary.begin(), region_boundary.end());
+	region_seeds.assign(region_boundary.begin(), region_boundary.end());
+	region_callees.clear();
+	region_pointer_calls.clear();
+
+	for (auto F : region_funcs) {
+		DyckCallGraphNode* node = call_graph->getOrInsertFunction(F);
+
+		vector<Value*> bound;
+		for (auto& arg : F->getArgumentList()) {
+			bound.push_back(&arg);
+		}
+		bound.insert(bound.end(), node->getReturns().begin(), node->getReturns().end());
+		bound.insert(bound.end(), node->getVAArgs().begin(), node->getVAArgs().end());
+
+		if (boundary.count(F)) {
+			// the calls out of the region are bound to the function
+			region_seeds.insert(region_seeds.end(), bound.begin(), bound.end());
+		}
+		region_callees.push_back(make_pair(F, bound));
+
+		for (auto pcall : node->getPointerCalls()) {
+			vector<Value*> args(pcall->args);
+			if (pcall->instruction) {
+				args.push_back(pcall->instruction);
+			}
+			region_pointer_calls.push_back(make_pair(pcall->calledValue, args));
+		}
+	}
+}
+
+void DyckAliasAnalysis::indexRegionStability() {
+	DyckCSR* csr = dyck_graph->getCSR();
+	assert(csr != NULL);
+	unsigned n = csr->numVertices();
+
+	auto getId = [this, csr](Value* v) {
+		DyckVertex* ver = dyck_graph->findDyckVertex(v);
+		return ver ? csr->getId(ver) : DyckCSR::InvalidId;
+	};
+
+	// The whole analysis adds constraints to the sets of the seeds, the sets reachable
+	// from them, whose targets may be merged, and the sets bound to them by the calls.
+	vector<bool> tainted(n, false);
+	stack<unsigned> workStack;
+	auto taint = [&](Value* v) {
+		unsigned id = getId(v);
+		if (id != DyckCSR::InvalidId && !tainted[id]) {
+			tainted[id] = true;
+			workStack.push(id);
+		}
+	};
+
+	for (auto v : region_seeds) {
+		taint(v);
+	}
+	while (!workStack.empty()) {
+		while (!workStack.empty()) {
+			unsigned top = workStack.top();
+			workStack.pop();
+			for (unsigned e = csr->outBegin(top); e != csr->outEnd(top); e++) {
+				unsigned tar = csr->outTarget(e);
+				if (!tainted[tar]) {
+					tainted[tar] = true;
+					workStack.push(tar);
+				}
+			}
+		}
+
+		// a pointer call or a function whose set is tainted may be bound to the
+		// functions or the calls out of the region
+		for (auto& calls : { &region_pointer_calls, &region_callees }) {
+			for (auto& call : *calls) {
+				unsigned id = getId(call.first);
+				if (id != DyckCSR::InvalidId && tainted[id]) {
+					for (auto v : call.second) {
+						taint(v);
+					}
+				}
+			}
+		}
+	}
+
+	// a set is stable if no tainted set is reachable from it, so that the sets and
+	// the offset reachability used by its queries are the same as the whole analysis
+	vector<unsigned> inOffsets(n + 1, 0);
+	for (unsigned id = 0; id < n; id++) {
+		for (unsigned e = csr->outBegin(id); e != csr->outEnd(id); e++) {
+			inOffsets[csr->outTarget(e) + 1]++;
+		}
+	}
+	for (unsigned id = 0; id < n; id++) {
+		inOffsets[id + 1] += inOffsets[id];
+	}
+	vector<unsigned> inSources(inOffsets[n]);
+	vector<unsigned> next(inOffsets.begin(), inOffsets.end() - 1);
+	for (unsigned id = 0; id < n; id++) {
+		for (unsigned e = csr->outBegin(id); e != csr->outEnd(id); e++) {
+			inSources[next[csr->outTarget(e)]++] = id;
+		}
+	}
+
+	region_stable.assign(n, true);
+	for (unsigned id = 0; id < n; id++) {
+		if (tainted[id]) {
+			region_stable[id] = false;
+			workStack.push(id);
+		}
+	}
+	while (!workStack.empty()) {
+		unsigned top = workStack.top();
+		workStack.pop();
+		for (unsigned i = inOffsets[top]; i < inOffsets[top + 1]; i++) {
+			unsigned src = inSources[i];
+			if (region_stable[src]) {
+				region_stable[src] = false;
+				workStack.push(src);
+			}
+		}
+	}
+
+	DEBUG_WITH_TYPE("dyckaa-stats",
+			outs() << "Region: " << std::count(region_stable.begin(), region_stable.end(), true) << " of " << n
+					<< " sets are the same as the whole analysis\n");
+
+	region_seeds.clear();
+	region_callees.clear();
+	region_pointer_calls.clear();
+}
+
+bool DyckAliasAnalysis::isSolved(const Value* v) const {
+	// the analysis of the region queries the graph before it is frozen
+	DyckCSR* csr = dyck_graph->getCSR();
+	if (region_funcs.empty() || csr == NULL) {
+		return true;
+	}
+
+	// a value out of the region has no vertex
+	DyckVertex* ver = dyck_graph->findDyckVertex(const_cast<Value*>(v));
+	if (ver == NULL) {
+		return false;
+	}
+	unsigned id = csr->getId(ver);
+	return id != DyckCSR::InvalidId && id < region_stable.size() && region_stable[id];
+}
+
+void DyckAliasAnalysis::indexRegionRest(Module& M) {
+	region_rest.clear();
+	auto add = [this](Value* v) {
+		if (dyck_graph->findDyckVertex(v) == NULL) {
+			region_rest.insert(v);
+		}
+	};
+
+	for (Module::global_iterator it = M.global_begin(); it != M.global_end(); it++) {
+		add(it);
+	}
+	for (Module::alias_iterator it = M.alias_begin(); it != M.alias_end(); it++) {
+		add(it);
+	}
+	for (auto& F : M) {
+		add(&F);
+		for (auto& arg : F.getArgumentList()) {
+			add(&arg);
+		}
+		for (auto& B : F) {
+			for (auto& I : B) {
+				add(&I);
+			}
+		}
+	}
+
+	region_mem_allocas.clear();
+	vector<const set<Value*>*> sets;
+	getAllSets(&sets);
+	for (auto vals : sets) {
+		collectMemAllocas(vals, region_mem_allocas);
+	}
+}
+
+void DyckAliasAnalysis::getAllSets(std::vector<const set<Value*>*>* ret) {
+	for (auto v : dyck_graph->getVertices()) {
+		if (v != NULL) {
+			ret->push_back((const set<Value*>*) v->getEquivalentSet());
+		}
+	}
+	if (!region_rest.empty()) {
+		ret->push_back(&region_rest);
+	}
+}
+
+void DyckAliasAnalysis::printAliasQueries(Module& M) {
+	std::error_code EC;
+	raw_fd_ostream log("alias_queries.log", EC, sys::fs::OpenFlags::F_RW);
+
+	const char* results[] = { "NoAlias", "MayAlias", "PartialAlias", "MustAlias" };
+	unsigned funcIdx = 0;
+	for (auto& F : M) {
+		// the pointers are numbered by their order in the function
+		vector<Value*> pointers;
+		for (auto& arg : F.getArgumentList()) {
+			if (arg.getType()->isPointerTy()) {
+				pointers.push_back(&arg);
+			}
+		}
+		for (auto& B : F) {
+			for (auto& I : B) {
+				if (I.getType()->isPointerTy()) {
+					pointers.push_back(&I);
+				}
+			}
+		}
+
+		for (unsigned i = 0; i < pointers.size(); i++) {
+			for (unsigned j = i + 1; j < pointers.size(); j++) {
+				log << funcIdx << ":" << F.getName() << " " << i << " " << j << " "
+						<< results[this->alias(pointers[i], pointers[j])] << "\n";
+			}
+		}
+
+		// the allocation sites of each pointer, sorted by their names
+		for (unsigned i = 0; i < pointers.size(); i++) {
+			vector<Value*>* objects = this->getDefaultPointstoMemAlloca(pointers[i]);
+			if (objects->empty()) {
+				continue;
+			}
+			vector<std::string> names;
+			for (auto object : *objects) {
+				names.push_back(object->getName().str());
+			}
+			std::sort(names.begin(), names.end());
+			log << funcIdx << ":" << F.getName() << " " << i << " allocas ";
+			for (unsigned k = 0; k < names.size(); k++) {
+				log << (k ? "," : "") << names[k];
+			}
+			log << "\n";
+		}
+		funcIdx++;
+	}
+
+	log.flush();
+	log.close();
 }
 
 void DyckAliasAnalysis::printAliasSetInformation(Module& M) {
 	/*if (InterAAEval)*/
 	{
-		set<DyckVertex*>& allreps = dyck_graph->getVertices();
+		const vector<DyckVertex*>& allreps = dyck_graph->getVertices();
 
 		outs() << "Printing distribution.log... ";
 		outs().flush();
@@ -510,8 +1187,12 @@ void DyckAliasAnalysis::printAliasSetInformation(Module& M) {
 
 		vector<unsigned long> aliasSetSizes;
 		double totalSize = 0;
-		set<DyckVertex*>::iterator it = allreps.begin();
+		auto it = allreps.begin();
 		while (it != allreps.end()) {
+			if (*it == NULL) {
+				it++;
+				continue;
+			}
 			set<void*>* aliasset = (*it)->getEquivalentSet();
 
 			unsigned long size = 0;
@@ -556,74 +1237,25 @@ void DyckAliasAnalysis::printAliasSetInformation(Module& M) {
 		outs() << "   " << noAliasNum << " no alias responses (" << (unsigned long) percentOfNoAlias << "%)\n\n";
 	}
 
+	// shared by alias_rel.dot and alias_sets.log
+	set<DyckVertex*> svs;
+	Function* PThreadCreate = M.getFunction("pthread_create");
+	if (PThreadCreate != NULL) {
+		this->getEscapedPointersTo(&svs, PThreadCreate);
+	}
+
 	/*if (DotAliasSet) */
 	{
 		outs() << "Printing alias_rel.dot... ";
 		outs().flush();
 
-		FILE * aliasRel = fopen("alias_rel.dot", "w");
-		fprintf(aliasRel, "digraph rel{\n");
-
-		set<DyckVertex*> svs;
-		Function* PThreadCreate = M.getFunction("pthread_create");
-		if (PThreadCreate != NULL) {
-			this->getEscapedPointersTo(&svs, PThreadCreate);
-		}
-
-		map<DyckVertex*, int> theMap;
-		int idx = 0;
-		set<DyckVertex*>& reps = dyck_graph->getVertices();
-		auto repIt = reps.begin();
-		while (repIt != reps.end()) {
-			idx++;
-			if (svs.count(*repIt)) {
-				fprintf(aliasRel, "a%d[label=%d color=red];\n", idx, idx);
-			} else {
-				fprintf(aliasRel, "a%d[label=%d];\n", idx, idx);
-			}
-			theMap.insert(pair<DyckVertex*, int>(*repIt, idx));
-			repIt++;
-		}
-
-		repIt = reps.begin();
-		while (repIt != reps.end()) {
-			DyckVertex* dv = *repIt;
-			map<void*, set<DyckVertex*>>& outVs = dv->getOutVertices();
-
-			auto ovIt = outVs.begin();
-			while (ovIt != outVs.end()) {
-				EdgeLabel* label = (EdgeLabel*) ovIt->first;
-				set<DyckVertex*>* oVs = &ovIt->second;
-
-				set<DyckVertex*>::iterator olIt = oVs->begin();
-				while (olIt != oVs->end()) {
-					DyckVertex * rep1 = dv;
-					DyckVertex * rep2 = (*olIt);
-
-					assert(theMap.count(rep1) && "ERROR in DotAliasSet (1)\n");
-					assert(theMap.count(rep2) && "ERROR in DotAliasSet (2)\n");
-
-					int idx1 = theMap[rep1];
-					int idx2 = theMap[rep2];
-
-					if (svs.count(rep1) && svs.count(rep2)) {
-						fprintf(aliasRel, "a%d->a%d[label=\"%s\" color=red];\n", idx1, idx2, label->getEdgeLabelDescription().data());
-					} else {
-						fprintf(aliasRel, "a%d->a%d[label=\"%s\"];\n", idx1, idx2, label->getEdgeLabelDescription().data());
-					}
-
-					olIt++;
-				}
-
-				ovIt++;
-			}
-
-			theMap.insert(pair<DyckVertex*, int>(*repIt, idx));
-			repIt++;
-		}
-
-		fprintf(aliasRel, "}\n");
-		fclose(aliasRel);
+		DyckGraphExporter exporter(dyck_graph);
+		exporter.setNumThreads(NumThreads);
+		exporter.setHighlighted(svs);
+		exporter.setLabelDescription([this](void* label) {
+			return edge_labels.getDescription(label);
+		});
+		exporter.write("alias_rel.dot", DyckGraphExporter::DOT);
 		outs() << "Done!\n";
 	}
 
@@ -635,21 +1267,14 @@ void DyckAliasAnalysis::printAliasSetInformation(Module& M) {
 		std::error_code EC;
 		raw_fd_ostream log("alias_sets.log", EC, sys::fs::OpenFlags::F_RW);
 
-		set<DyckVertex*> svs;
-		Function* PThreadCreate = M.getFunction("pthread_create");
-		if (PThreadCreate != NULL) {
-			this->getEscapedPointersTo(&svs, PThreadCreate);
-		}
-
 		log << "================= Alias Sets ==================\n";
 		log << "===== {.} means pthread escaped alias set =====\n";
 
-		int idx = 0;
-		set<DyckVertex*>& reps = dyck_graph->getVertices();
-		set<DyckVertex*>::iterator repsIt = reps.begin();
-		while (repsIt != reps.end()) {
-			idx++;
-			DyckVertex* rep = *repsIt;
+		// the sets are numbered as they are in alias_rel.dot
+		DyckCSR* csr = dyck_graph->getCSR();
+		for (unsigned id = 0; id < csr->numVertices(); id++) {
+			unsigned idx = id + 1;
+			DyckVertex* rep = csr->getVertex(id);
 
 			bool pthread_escaped = false;
 			if (svs.count(rep)) {
@@ -674,7 +1299,6 @@ void DyckAliasAnalysis::printAliasSetInformation(Module& M) {
 				}
 				eit++;
 			}
-			repsIt++;
 			log << "\n------------------------------\n";
 		}
 
@@ -0,0 +1,98 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#include "DyckAA/DyckResultCache.h"
+#include "DyckAA/DyckSnapshot.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <tuple>
+
+static const char* SnapshotSuffix = ".dsnap";
+
+DyckResultCache::DyckResultCache(const string& d, const string& seed, uint64_t maxBytes, Module& M, MD5& options) :
+		dir(d), seed_dir(seed), max_bytes(maxBytes), cache_hit(false) {
+	MD5::MD5Result moduleHash;
+	DyckSnapshot::hashModule(M, moduleHash);
+
+	uint32_t version = DyckSnapshot::Version;
+	options.update(ArrayRef<uint8_t>((const uint8_t*) &version, sizeof(version)));
+	options.update(ArrayRef<uint8_t>(moduleHash, sizeof(moduleHash)));
+
+	MD5::MD5Result result;
+	options.final(result);
+	SmallString<32> hex;
+	MD5::stringifyResult(result, hex);
+	key = hex.str().str() + SnapshotSuffix;
+}
+
+string DyckResultCache::getPath(const string& d) const {
+	SmallString<128> path(d);
+	sys::path::append(path, key);
+	return path.str().str();
+}
+
+bool DyckResultCache::load(Module& M, DyckGraph* dg, DyckCallGraph* cg, EdgeLabel& labels) {
+	if (!dir.empty()) {
+		string path = getPath(dir);
+		if (DyckSnapshot::load(path.c_str(), M, dg, cg, labels)) {
+			// the snapshot is used recently
+			int fd;
+			if (!sys::fs::openFileForRead(path, fd)) {
+				sys::fs::setLastModificationAndAccessTime(fd, sys::TimeValue::now());
+				close(fd);
+			}
+			cache_hit = true;
+			return true;
+		}
+	}
+
+	return !seed_dir.empty() && DyckSnapshot::load(getPath(seed_dir).c_str(), M, dg, cg, labels);
+}
+
+bool DyckResultCache::save(Module& M, DyckGraph* dg, DyckCallGraph* cg, EdgeLabel& labels) {
+	if (sys::fs::create_directories(dir)) {
+		return false;
+	}
+
+	// the snapshot replaces the file atomically
+	if (!DyckSnapshot::save(getPath(dir).c_str(), M, dg, cg, labels)) {
+		return false;
+	}
+
+	evict();
+	return true;
+}
+
+void DyckResultCache::evict() {
+	// (modification time, size, path) of the snapshots
+	vector<std::tuple<sys::TimeValue, uint64_t, string> > files;
+	uint64_t total = 0;
+
+	std::error_code ec;
+	for (sys::fs::directory_iterator it(dir, ec), end; it != end && !ec; it.increment(ec)) {
+		const string& path = it->path();
+		sys::fs::file_status st;
+		if (!StringRef(path).endswith(SnapshotSuffix) || it->status(st) || !sys::fs::is_regular_file(st)) {
+			continue;
+		}
+		files.push_back(std::make_tuple(st.getLastModificationTime(), st.getSize(), path));
+		total += st.getSize();
+	}
+
+	std::sort(files.begin(), files.end());
+	for (auto& f : files) {
+		if (total <= max_bytes) {
+			break;
+		}
+		// another process may have removed it
+		sys::fs::remove(std::get<2>(f));
+		total -= std::get<1>(f);
+	}
+}
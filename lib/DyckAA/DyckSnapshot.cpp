@@ -0,0 +1,623 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#include "DyckAA/DyckSnapshot.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <string.h>
+#include <algorithm>
+
+namespace {
+
+enum ValueKeyKind {
+	GLOBAL_KEY, ARGUMENT_KEY, INSTRUCTION_KEY, CONSTANT_KEY
+};
+
+enum CallFlags {
+	POINTER_CALL = 1, MUST_ALIASED_CALL = 2
+};
+
+const uint32_t NoValue = ~0u;
+
+struct SnapshotHeader {
+	char magic[8];
+	uint32_t version;
+
+	/// the MD5 of the bitcode of the module, see DyckSnapshot::hashModule()
+	uint8_t module_hash[16];
+
+	/// The sizes of the sections that follow the header in order,
+	/// all of them are in 32-bit words except the string table.
+	/// @{
+	uint32_t strings_bytes; // a multiple of 4
+	uint32_t num_values; // 3 words each: kind, name or function number, ordinal
+	uint32_t num_classes; // num_classes + 1 offsets into class values
+	uint32_t num_class_values;
+	uint32_t num_labels; // 3 words each: kind, low and high 32 bits of the value
+	uint32_t num_edges; // 3 words each: source class, label, target class
+	uint32_t call_words;
+	/// @}
+};
+
+const char SnapshotMagic[8] = { 'D', 'Y', 'C', 'K', 'S', 'N', 'A', 'P' };
+
+/// Numbers the instructions of each function and the constants of a module,
+/// which are not identified by names, in a fixed order.
+class ValueNumbering {
+private:
+	DenseMap<const Value*, uint32_t> inst_ordinals;
+	DenseMap<const Value*, uint32_t> constant_ids;
+
+	void addConstant(Constant* c) {
+		if (isa<GlobalValue>(c) && c->hasName()) {
+			return;
+		}
+
+		if (constant_ids.count(c)) {
+			return;
+		}
+
+		constant_ids[c] = constants.size();
+		constants.push_back(c);
+
+		for (unsigned i = 0; i < c->getNumOperands(); i++) {
+			if (Constant* op = dyn_cast<Constant>(c->getOperand(i))) {
+				addConstant(op);
+			}
+		}
+	}
+
+public:
+	vector<Constant*> constants;
+	vector<Function*> functions;
+	DenseMap<const Function*, uint32_t> function_ids;
+	DenseMap<const Function*, vector<Instruction*> > function_insts;
+
+	/// If forLoading is true, the instructions of each function are kept
+	/// in a vector, otherwise their ordinals are kept in a map.
+	ValueNumbering(Module& M, bool forLoading) {
+		for (Module::global_iterator it = M.global_begin(); it != M.global_end(); it++) {
+			addConstant(it);
+			if (it->hasInitializer()) {
+				addConstant(it->getInitializer());
+			}
+		}
+
+		for (Module::alias_iterator it = M.alias_begin(); it != M.alias_end(); it++) {
+			addConstant(it);
+			if (Constant* aliasee = it->getAliasee()) {
+				addConstant(aliasee);
+			}
+		}
+
+		for (Module::iterator it = M.begin(); it != M.end(); it++) {
+			function_ids[it] = functions.size();
+			functions.push_back(it);
+			addConstant(it);
+		}
+
+		for (Module::iterator it = M.begin(); it != M.end(); it++) {
+			Function* F = it;
+			vector<Instruction*>* insts = forLoading ? &function_insts[F] : NULL;
+
+			uint32_t ordinal = 0;
+			for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I, ++ordinal) {
+				Instruction* inst = &*I;
+				if (forLoading) {
+					insts->push_back(inst);
+				} else {
+					inst_ordinals[inst] = ordinal;
+				}
+
+				for (unsigned i = 0; i < inst->getNumOperands(); i++) {
+					if (Constant* op = dyn_cast<Constant>(inst->getOperand(i))) {
+						addConstant(op);
+					}
+				}
+			}
+		}
+	}
+
+	/// Return false if the value cannot be identified. The function number of an
+	/// argument or an instruction is returned by func.
+	bool getKey(Value* v, uint32_t& kind, StringRef& name, uint32_t& func, uint32_t& ordinal) {
+		if (isa<GlobalValue>(v) && v->hasName()) {
+			kind = GLOBAL_KEY;
+			name = v->getName();
+			ordinal = 0;
+			return true;
+		}
+
+		if (Argument* arg = dyn_cast<Argument>(v)) {
+			auto fit = function_ids.find(arg->getParent());
+			if (fit == function_ids.end()) {
+				return false;
+			}
+			kind = ARGUMENT_KEY;
+			func = fit->second;
+			ordinal = arg->getArgNo();
+			return true;
+		}
+
+		if (Instruction* inst = dyn_cast<Instruction>(v)) {
+			auto fit = function_ids.find(inst->getParent()->getParent());
+			auto it = inst_ordinals.find(inst);
+			if (fit == function_ids.end() || it == inst_ordinals.end()) {
+				return false;
+			}
+			kind = INSTRUCTION_KEY;
+			func = fit->second;
+			ordinal = it->second;
+			return true;
+		}
+
+		auto it = constant_ids.find(v);
+		if (it != constant_ids.end()) {
+			kind = CONSTANT_KEY;
+			name = "";
+			ordinal = it->second;
+			return true;
+		}
+
+		return false;
+	}
+
+	/// Return NULL if the key does not match any value. The name is only used by
+	/// global values, and the function number by arguments and instructions.
+	Value* resolve(Module& M, uint32_t kind, const char* name, uint32_t func, uint32_t ordinal) {
+		Function* F = func < functions.size() ? functions[func] : NULL;
+		switch (kind) {
+		case GLOBAL_KEY:
+			return M.getNamedValue(name);
+		case ARGUMENT_KEY: {
+			if (F == NULL || ordinal >= F->arg_size()) {
+				return NULL;
+			}
+			Function::arg_iterator ait = F->arg_begin();
+			std::advance(ait, ordinal);
+			return ait;
+		}
+		case INSTRUCTION_KEY: {
+			if (F == NULL) {
+				return NULL;
+			}
+			vector<Instruction*>& insts = function_insts[F];
+			return ordinal < insts.size() ? insts[ordinal] : NULL;
+		}
+		case CONSTANT_KEY:
+			return ordinal < constants.size() ? constants[ordinal] : NULL;
+		default:
+			return NULL;
+		}
+	}
+};
+
+/// Collects the values and the strings referred to by a snapshot.
+class ValueTable {
+private:
+	ValueNumbering& numbering;
+	DenseMap<Value*, uint32_t> value_ids;
+	map<string, uint32_t> string_offsets;
+
+public:
+	string strings;
+	vector<uint32_t> value_words;
+
+	/// true if a value cannot be identified
+	bool failed;
+
+	ValueTable(ValueNumbering& n) :
+			numbering(n), failed(false) {
+	}
+
+	uint32_t getOrInsertString(StringRef str) {
+		auto it = string_offsets.find(str.str());
+		if (it != string_offsets.end()) {
+			return it->second;
+		}
+
+		uint32_t offset = strings.size();
+		strings.append(str.data(), str.size());
+		strings.push_back('\0');
+		string_offsets[str.str()] = offset;
+		return offset;
+	}
+
+	/// Return NoValue if the value is NULL or it cannot be identified.
+	uint32_t getOrInsertValue(Value* v) {
+		if (v == NULL) {
+			return NoValue;
+		}
+
+		auto it = value_ids.find(v);
+		if (it != value_ids.end()) {
+			return it->second;
+		}
+
+		uint32_t kind, func = 0, ordinal;
+		StringRef name;
+		uint32_t id = NoValue;
+		if (numbering.getKey(v, kind, name, func, ordinal)) {
+			id = value_words.size() / 3;
+			value_words.push_back(kind);
+			value_words.push_back(kind == GLOBAL_KEY ? getOrInsertString(name) : func);
+			value_words.push_back(ordinal);
+		} else {
+			failed = true;
+		}
+		value_ids[v] = id;
+		return id;
+	}
+};
+
+}
+
+void DyckSnapshot::hashModule(Module& M, MD5::MD5Result& result) {
+	string bitcode;
+	raw_string_ostream os(bitcode);
+	WriteBitcodeToFile(&M, os);
+	os.flush();
+
+	MD5 hasher;
+	hasher.update(bitcode);
+	hasher.final(result);
+}
+
+bool DyckSnapshot::save(const char* file, Module& M, DyckGraph* dg, DyckCallGraph* cg, EdgeLabel& labels) {
+	if (dg->getCSR() == NULL) {
+		dg->freeze();
+	}
+	DyckCSR* csr = dg->getCSR();
+
+	ValueNumbering numbering(M, false);
+	ValueTable table(numbering);
+	table.getOrInsertString("");
+
+	// equivalent sets
+	vector<uint32_t> class_offsets;
+	vector<uint32_t> class_values;
+	for (unsigned id = 0; id < csr->numVertices(); id++) {
+		class_offsets.push_back(class_values.size());
+		set<void*>* vals = csr->getVertex(id)->getEquivalentSet();
+		for (auto val : *vals) {
+			uint32_t vid = table.getOrInsertValue((Value*) val);
+			if (vid != NoValue) {
+				class_values.push_back(vid);
+			}
+		}
+	}
+	class_offsets.push_back(class_values.size());
+
+	// edges
+	map<unsigned, uint32_t> label_ids;
+	vector<uint32_t> label_words;
+	vector<uint32_t> edge_words;
+	for (unsigned id = 0; id < csr->numVertices(); id++) {
+		for (unsigned e = csr->outBegin(id); e != csr->outEnd(id); e++) {
+			auto lit = label_ids.find(csr->outLabel(e));
+			if (lit == label_ids.end()) {
+				void* label = dg->getLabel(csr->outLabel(e));
+				uint64_t value = (uint64_t) labels.getValue(label);
+				lit = label_ids.insert(make_pair(csr->outLabel(e), (uint32_t) label_ids.size())).first;
+				label_words.push_back(EdgeLabel::getLabelTy(label));
+				label_words.push_back((uint32_t) value);
+				label_words.push_back((uint32_t) (value >> 32));
+			}
+
+			edge_words.push_back(id);
+			edge_words.push_back(lit->second);
+			edge_words.push_back(csr->outTarget(e));
+		}
+	}
+
+	// calls of each function: caller, number of calls, and then for each call:
+	// flags, instruction, called value, number of args, args, number of callees, callees
+	vector<uint32_t> call_words;
+	if (cg) {
+		map<Function*, DyckCallGraphNode*> nodes(cg->begin(), cg->end());
+		for (Module::iterator it = M.begin(); it != M.end(); it++) {
+			auto nit = nodes.find(it);
+			if (nit == nodes.end()) {
+				continue;
+			}
+			uint32_t caller = table.getOrInsertValue(it);
+
+			vector<pair<Call*, uint32_t> > calls;
+			for (auto call : nit->second->getCommonCalls()) {
+				calls.push_back(make_pair((Call*) call, 0));
+			}
+			for (auto call : nit->second->getPointerCalls()) {
+				calls.push_back(make_pair((Call*) call, POINTER_CALL | (call->mustAliasedPointerCall ? MUST_ALIASED_CALL : 0)));
+			}
+
+			vector<uint32_t> words;
+			uint32_t numCalls = 0;
+			for (auto& c : calls) {
+				Call* call = c.first;
+				numCalls++;
+
+				words.push_back(c.second);
+				words.push_back(table.getOrInsertValue(call->instruction));
+				words.push_back(table.getOrInsertValue(call->calledValue));
+				words.push_back(call->args.size());
+				for (auto arg : call->args) {
+					words.push_back(table.getOrInsertValue(arg));
+				}
+
+				if (c.second & POINTER_CALL) {
+					set<Function*>& callees = ((PointerCall*) call)->mayAliasedCallees;
+					words.push_back(callees.size());
+					for (auto callee : callees) {
+						words.push_back(table.getOrInsertValue(callee));
+					}
+				} else {
+					words.push_back(0);
+				}
+			}
+
+			call_words.push_back(caller);
+			call_words.push_back(numCalls);
+			call_words.insert(call_words.end(), words.begin(), words.end());
+		}
+	}
+
+	// a value left out would have no aliases after loading
+	if (table.failed) {
+		return false;
+	}
+
+	while (table.strings.size() % 4) {
+		table.strings.push_back('\0');
+	}
+
+	SnapshotHeader header;
+	memcpy(header.magic, SnapshotMagic, sizeof(SnapshotMagic));
+	header.version = Version;
+	MD5::MD5Result moduleHash;
+	hashModule(M, moduleHash);
+	memcpy(header.module_hash, moduleHash, sizeof(header.module_hash));
+	header.strings_bytes = table.strings.size();
+	header.num_values = table.value_words.size() / 3;
+	header.num_classes = class_offsets.size() - 1;
+	header.num_class_values = class_values.size();
+	header.num_labels = label_words.size() / 3;
+	header.num_edges = edge_words.size() / 3;
+	header.call_words = call_words.size();
+
+	// the file is written aside and renamed, so that a reader never sees a partial one
+	int fd;
+	SmallString<128> tmp;
+	if (sys::fs::createUniqueFile(Twine(file) + ".tmp-%%%%%%%%", fd, tmp)) {
+		return false;
+	}
+
+	raw_fd_ostream os(fd, true);
+	os.write((const char*) &header, sizeof(header));
+	os.write(table.strings.data(), table.strings.size());
+	const vector<uint32_t>* sections[] = { &table.value_words, &class_offsets, &class_values, &label_words,
+			&edge_words, &call_words };
+	for (auto words : sections) {
+		os.write((const char*) words->data(), words->size() * sizeof(uint32_t));
+	}
+	os.close();
+	if (os.has_error()) {
+		os.clear_error();
+		sys::fs::remove(tmp.str());
+		return false;
+	}
+
+	if (sys::fs::rename(tmp.str(), file)) {
+		sys::fs::remove(tmp.str());
+		return false;
+	}
+	return true;
+}
+
+bool DyckSnapshot::load(const char* file, Module& M, DyckGraph* dg, DyckCallGraph* cg, EdgeLabel& labels) {
+	ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(file, -1, false);
+	if (!buffer) {
+		return false;
+	}
+
+	const char* data = (*buffer)->getBufferStart();
+	uint64_t size = (*buffer)->getBufferSize();
+
+	// check the header
+	if (size < sizeof(SnapshotHeader)) {
+		return false;
+	}
+	const SnapshotHeader* header = (const SnapshotHeader*) data;
+	if (memcmp(header->magic, SnapshotMagic, sizeof(SnapshotMagic)) || header->version != Version
+			|| header->strings_bytes % 4) {
+		return false;
+	}
+
+	uint64_t expected = sizeof(SnapshotHeader) + header->strings_bytes;
+	expected += 4 * (3 * (uint64_t) header->num_values + header->num_classes + 1 + header->num_class_values);
+	expected += 4 * (3 * (uint64_t) header->num_labels + 3 * (uint64_t) header->num_edges + header->call_words);
+	if (size != expected) {
+		return false;
+	}
+
+	const char* strings = data + sizeof(SnapshotHeader);
+	const uint32_t* value_words = (const uint32_t*) (strings + header->strings_bytes);
+	const uint32_t* class_offsets = value_words + 3 * header->num_values;
+	const uint32_t* class_values = class_offsets + header->num_classes + 1;
+	const uint32_t* label_words = class_values + header->num_class_values;
+	const uint32_t* edge_words = label_words + 3 * header->num_labels;
+	const uint32_t* call_words = edge_words + 3 * header->num_edges;
+
+	// check the module
+	MD5::MD5Result moduleHash;
+	hashModule(M, moduleHash);
+	if (memcmp(header->module_hash, moduleHash, sizeof(header->module_hash))) {
+		return false;
+	}
+	ValueNumbering numbering(M, true);
+
+	// resolve the values
+	if (header->strings_bytes == 0 || strings[header->strings_bytes - 1] != '\0') {
+		return false;
+	}
+	vector<Value*> values(header->num_values, NULL);
+	for (uint32_t i = 0; i < header->num_values; i++) {
+		uint32_t kind = value_words[3 * i];
+		uint32_t nameOrFunc = value_words[3 * i + 1];
+		if (kind == GLOBAL_KEY && nameOrFunc >= header->strings_bytes) {
+			return false;
+		}
+		const char* name = kind == GLOBAL_KEY ? strings + nameOrFunc : "";
+		values[i] = numbering.resolve(M, kind, name, nameOrFunc, value_words[3 * i + 2]);
+		if (values[i] == NULL) {
+			return false;
+		}
+	}
+
+	// check the equivalent sets, the labels and the edges
+	if (class_offsets[0] != 0 || class_offsets[header->num_classes] != header->num_class_values) {
+		return false;
+	}
+	for (uint32_t c = 0; c < header->num_classes; c++) {
+		if (class_offsets[c] > class_offsets[c + 1]) {
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header->num_class_values; i++) {
+		if (class_values[i] >= header->num_values) {
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header->num_labels; i++) {
+		uint32_t kind = label_words[3 * i];
+		if (kind != EdgeLabel::DEREF_TYPE && kind != EdgeLabel::OFFSET_TYPE && kind != EdgeLabel::INDEX_TYPE) {
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header->num_edges; i++) {
+		if (edge_words[3 * i] >= header->num_classes || edge_words[3 * i + 1] >= header->num_labels
+				|| edge_words[3 * i + 2] >= header->num_classes) {
+			return false;
+		}
+	}
+
+	// check the calls
+	auto isValueOf = [&](uint32_t id, bool function, bool nullable) {
+		if (id == NoValue) {
+			return nullable;
+		}
+		return id < header->num_values && (!function || isa<Function>(values[id]));
+	};
+	uint32_t pos = 0;
+	while (pos < header->call_words) {
+		if (header->call_words - pos < 2 || !isValueOf(call_words[pos], true, false)) {
+			return false;
+		}
+		uint32_t numCalls = call_words[pos + 1];
+		pos += 2;
+
+		for (uint32_t i = 0; i < numCalls; i++) {
+			if (header->call_words - pos < 4) {
+				return false;
+			}
+			bool pointerCall = call_words[pos] & POINTER_CALL;
+			if (!isValueOf(call_words[pos + 1], false, true) || !isValueOf(call_words[pos + 2], !pointerCall, false)
+					|| (call_words[pos + 1] != NoValue && !isa<Instruction>(values[call_words[pos + 1]]))) {
+				return false;
+			}
+			uint32_t numArgs = call_words[pos + 3];
+			pos += 4;
+			if (header->call_words - pos < (uint64_t) numArgs + 1) {
+				return false;
+			}
+			for (uint32_t a = 0; a < numArgs; a++) {
+				if (!isValueOf(call_words[pos + a], false, true)) {
+					return false;
+				}
+			}
+			pos += numArgs;
+
+			uint32_t numCallees = call_words[pos++];
+			if (header->call_words - pos < numCallees) {
+				return false;
+			}
+			for (uint32_t e = 0; e < numCallees; e++) {
+				if (!isValueOf(call_words[pos + e], true, false)) {
+					return false;
+				}
+			}
+			pos += numCallees;
+		}
+	}
+
+	// the snapshot is well-formed, build the graph
+	vector<DyckVertex*> class_vers(header->num_classes, NULL);
+	for (uint32_t c = 0; c < header->num_classes; c++) {
+		DyckVertex* rep = NULL;
+		for (uint32_t i = class_offsets[c]; i < class_offsets[c + 1]; i++) {
+			DyckVertex* ver = dg->retrieveDyckVertex(values[class_values[i]]).first;
+			rep = rep ? dg->combine(rep, ver) : ver;
+		}
+		if (rep == NULL) {
+			rep = dg->retrieveDyckVertex(NULL).first;
+		}
+		class_vers[c] = rep;
+	}
+
+	vector<void*> label_vec(header->num_labels, NULL);
+	for (uint32_t i = 0; i < header->num_labels; i++) {
+		uint64_t value = label_words[3 * i + 1] | ((uint64_t) label_words[3 * i + 2] << 32);
+		label_vec[i] = labels.getOrInsertLabel((EdgeLabel::LABEL_TY) label_words[3 * i], (long) value);
+	}
+
+	for (uint32_t i = 0; i < header->num_edges; i++) {
+		DyckVertex* src = class_vers[edge_words[3 * i]];
+		DyckVertex* dst = class_vers[edge_words[3 * i + 2]];
+		src->addTarget(dst, label_vec[edge_words[3 * i + 1]]);
+	}
+
+	// and the call graph
+	pos = 0;
+	while (pos < header->call_words) {
+		DyckCallGraphNode* node = cg->getOrInsertFunction((Function*) values[call_words[pos]]);
+		uint32_t numCalls = call_words[pos + 1];
+		pos += 2;
+
+		for (uint32_t i = 0; i < numCalls; i++) {
+			uint32_t flags = call_words[pos];
+			Instruction* inst = call_words[pos + 1] == NoValue ? NULL : (Instruction*) values[call_words[pos + 1]];
+			Value* calledValue = values[call_words[pos + 2]];
+			uint32_t numArgs = call_words[pos + 3];
+			pos += 4;
+
+			vector<Value*> args;
+			for (uint32_t a = 0; a < numArgs; a++) {
+				args.push_back(call_words[pos + a] == NoValue ? NULL : values[call_words[pos + a]]);
+			}
+			pos += numArgs;
+
+			uint32_t numCallees = call_words[pos++];
+			if (flags & POINTER_CALL) {
+				PointerCall* call = new PointerCall(inst, calledValue, &args);
+				call->mustAliasedPointerCall = flags & MUST_ALIASED_CALL;
+				for (uint32_t e = 0; e < numCallees; e++) {
+					call->mayAliasedCallees.insert((Function*) values[call_words[pos + e]]);
+				}
+				node->addPointerCall(call);
+			} else {
+				node->addCommonCall(new CommonCall(inst, (Function*) calledValue, &args));
+			}
+			pos += numCallees;
+		}
+	}
+
+	return true;
+}
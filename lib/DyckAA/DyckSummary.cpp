@@ -0,0 +1,808 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#include "DyckAA/DyckSummary.h"
+#include "Annotation/LibraryModel.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <string.h>
+
+namespace {
+
+enum ValueKeyKind {
+	ARGUMENT_KEY, INSTRUCTION_KEY, OPERAND_KEY
+};
+
+enum CallFlags {
+	POINTER_CALL = 1
+};
+
+const uint32_t NoValue = ~0u;
+
+struct SummaryHeader {
+	char magic[8];
+	uint32_t version;
+
+	/// used to check whether the summary is of the function
+	/// @{
+	uint32_t hash_low;
+	uint32_t hash_high;
+	uint32_t num_args;
+	uint32_t num_insts;
+	/// @}
+
+	/// The sizes of the sections that follow the header in order, in 32-bit words.
+	/// @{
+	uint32_t num_values; // 3 words each: kind, ordinal, operand number
+	uint32_t num_classes; // num_classes + 1 offsets into class values
+	uint32_t num_class_values;
+	uint32_t num_labels; // 3 words each: kind, low and high 32 bits of the value
+	uint32_t num_edges; // 3 words each: source class, label, target class
+	uint32_t fact_words;
+	/// @}
+};
+
+const char SummaryMagic[8] = { 'D', 'Y', 'C', 'K', 'S', 'U', 'M', 'M' };
+
+/// FNV-1a, which does not depend on the process like llvm::hash_code may do.
+class Fnv {
+private:
+	uint64_t value;
+
+public:
+	Fnv() :
+			value(14695981039346656037ULL) {
+	}
+
+	void add(const void* data, size_t size) {
+		const unsigned char* bytes = (const unsigned char*) data;
+		for (size_t i = 0; i < size; i++) {
+			value = (value ^ bytes[i]) * 1099511628211ULL;
+		}
+	}
+
+	void add(uint64_t v) {
+		add(&v, sizeof(v));
+	}
+
+	void add(StringRef str) {
+		add(str.size());
+		add(str.data(), str.size());
+	}
+
+	uint64_t get() const {
+		return value;
+	}
+};
+
+/// Hashes what the intra-procedural analysis of a function depends on.
+class StructuralHasher {
+private:
+	DenseMap<Type*, uint64_t> type_hashes;
+	DenseMap<Constant*, uint64_t> constant_hashes;
+	set<Type*> types_in_progress;
+
+	/// the ordinals of the instructions and the blocks of the function
+	DenseMap<const Value*, uint32_t> local_ordinals;
+
+public:
+	/// false if anything cannot be hashed
+	bool ok;
+
+	StructuralHasher(Function* F) :
+			ok(true) {
+		uint32_t ordinal = 0;
+		for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+			local_ordinals[&*I] = ordinal++;
+		}
+		ordinal = 0;
+		for (Function::iterator it = F->begin(); it != F->end(); it++) {
+			local_ordinals[it] = ordinal++;
+		}
+	}
+
+	uint64_t hashType(Type* ty) {
+		auto it = type_hashes.find(ty);
+		if (it != type_hashes.end()) {
+			return it->second;
+		}
+
+		Fnv f;
+		f.add(ty->getTypeID());
+		StructType* sty = dyn_cast<StructType>(ty);
+		if (sty && sty->hasName()) {
+			f.add(sty->getName());
+			// a recursive type is cut at its name
+			if (!types_in_progress.insert(ty).second) {
+				return f.get();
+			}
+		}
+
+		switch (ty->getTypeID()) {
+		case Type::IntegerTyID:
+			f.add(ty->getIntegerBitWidth());
+			break;
+		case Type::PointerTyID:
+			f.add(ty->getPointerAddressSpace());
+			f.add(hashType(ty->getPointerElementType()));
+			break;
+		case Type::FunctionTyID: {
+			FunctionType* fty = (FunctionType*) ty;
+			f.add(fty->isVarArg());
+			f.add(hashType(fty->getReturnType()));
+			f.add(fty->getNumParams());
+			for (unsigned i = 0; i < fty->getNumParams(); i++) {
+				f.add(hashType(fty->getParamType(i)));
+			}
+		}
+			break;
+		case Type::StructTyID:
+			f.add(sty->isPacked());
+			f.add(sty->isOpaque());
+			f.add(sty->getNumElements());
+			for (unsigned i = 0; i < sty->getNumElements(); i++) {
+				f.add(hashType(sty->getElementType(i)));
+			}
+			break;
+		case Type::ArrayTyID:
+			f.add(ty->getArrayNumElements());
+			f.add(hashType(ty->getArrayElementType()));
+			break;
+		case Type::VectorTyID:
+			f.add(ty->getVectorNumElements());
+			f.add(hashType(ty->getVectorElementType()));
+			break;
+		default:
+			break;
+		}
+
+		types_in_progress.erase(ty);
+		type_hashes[ty] = f.get();
+		return f.get();
+	}
+
+	uint64_t hashConstant(Constant* c) {
+		auto it = constant_hashes.find(c);
+		if (it != constant_hashes.end()) {
+			return it->second;
+		}
+
+		Fnv f;
+		f.add(c->getValueID());
+		f.add(hashType(c->getType()));
+		if (GlobalValue* gv = dyn_cast<GlobalValue>(c)) {
+			if (!gv->hasName()) {
+				ok = false;
+			}
+			f.add(gv->getName());
+			if (Function* func = dyn_cast<Function>(gv)) {
+				// a call of a function without body is handled by its library models
+				f.add(func->empty());
+				const vector<LibraryEffect>* effects = LibraryModels::get().lookup(func->getName());
+				if (func->empty() && effects) {
+					for (auto& effect : *effects) {
+						f.add(effect.kind);
+						f.add(effect.numArgs);
+						f.add(effect.first);
+						f.add(effect.second);
+					}
+				}
+			} else if (GlobalAlias* ga = dyn_cast<GlobalAlias>(gv)) {
+				// a call of an alias is resolved via its aliasee
+				if (ga->getAliasee()) {
+					f.add(hashConstant(ga->getAliasee()));
+				}
+			}
+		} else if (ConstantInt* ci = dyn_cast<ConstantInt>(c)) {
+			const APInt& v = ci->getValue();
+			f.add(v.getRawData(), v.getNumWords() * sizeof(uint64_t));
+		} else if (ConstantFP* cfp = dyn_cast<ConstantFP>(c)) {
+			APInt v = cfp->getValueAPF().bitcastToAPInt();
+			f.add(v.getRawData(), v.getNumWords() * sizeof(uint64_t));
+		} else if (ConstantDataSequential* cds = dyn_cast<ConstantDataSequential>(c)) {
+			f.add(cds->getRawDataValues());
+		} else {
+			if (ConstantExpr* ce = dyn_cast<ConstantExpr>(c)) {
+				f.add(ce->getOpcode());
+				if (ce->isCompare()) {
+					f.add(ce->getPredicate());
+				}
+				if (ce->hasIndices()) {
+					for (auto idx : ce->getIndices()) {
+						f.add(idx);
+					}
+				}
+			}
+
+			f.add(c->getNumOperands());
+			for (unsigned i = 0; i < c->getNumOperands(); i++) {
+				Value* op = c->getOperand(i);
+				if (Constant* opc = dyn_cast<Constant>(op)) {
+					f.add(hashConstant(opc));
+				} else if (BasicBlock* bb = dyn_cast<BasicBlock>(op)) {
+					// the block of a block address, which may be of another function
+					f.add(std::distance(bb->getParent()->begin(), Function::iterator(bb)));
+				} else {
+					ok = false;
+				}
+			}
+		}
+
+		constant_hashes[c] = f.get();
+		return f.get();
+	}
+
+	uint64_t hashOperand(Value* v) {
+		Fnv f;
+		f.add(v->getValueID());
+		if (isa<Instruction>(v) || isa<BasicBlock>(v)) {
+			auto it = local_ordinals.find(v);
+			if (it == local_ordinals.end()) {
+				ok = false;
+			} else {
+				f.add(it->second);
+			}
+		} else if (Argument* arg = dyn_cast<Argument>(v)) {
+			f.add(arg->getArgNo());
+		} else if (Constant* c = dyn_cast<Constant>(v)) {
+			f.add(hashConstant(c));
+		} else if (InlineAsm* ia = dyn_cast<InlineAsm>(v)) {
+			f.add(hashType(ia->getType()));
+			f.add(ia->getAsmString());
+			f.add(ia->getConstraintString());
+		} else if (!isa<MetadataAsValue>(v)) {
+			// metadata are only used by intrinsics like llvm.dbg.declare
+			ok = false;
+		}
+		return f.get();
+	}
+};
+
+/// Identifies the values of a function by their places in it.
+class LocalNumbering {
+private:
+	DenseMap<Value*, uint32_t> value_ids;
+	DenseMap<Value*, std::tuple<uint32_t, uint32_t, uint32_t> > keys;
+
+public:
+	vector<Argument*> args;
+	vector<Instruction*> insts;
+
+	/// the key of each value in value_ids, 3 words each
+	vector<uint32_t> value_words;
+
+	/// If forSaving is true, the keys of the values are computed.
+	LocalNumbering(Function* F, bool forSaving) {
+		for (Function::arg_iterator it = F->arg_begin(); it != F->arg_end(); it++) {
+			args.push_back(it);
+			if (forSaving) {
+				keys[args.back()] = std::make_tuple(ARGUMENT_KEY, args.size() - 1, 0);
+			}
+		}
+
+		for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+			insts.push_back(&*I);
+		}
+
+		if (forSaving) {
+			for (uint32_t i = 0; i < insts.size(); i++) {
+				keys[insts[i]] = std::make_tuple(INSTRUCTION_KEY, i, 0);
+			}
+			for (uint32_t i = 0; i < insts.size(); i++) {
+				for (uint32_t op = 0; op < insts[i]->getNumOperands(); op++) {
+					Value* v = insts[i]->getOperand(op);
+					if (!keys.count(v)) {
+						keys[v] = std::make_tuple(OPERAND_KEY, i, op);
+					}
+				}
+			}
+		}
+	}
+
+	/// Return NoValue if the value cannot be identified.
+	uint32_t getOrInsertValue(Value* v) {
+		if (v == NULL) {
+			return NoValue;
+		}
+
+		auto it = value_ids.find(v);
+		if (it != value_ids.end()) {
+			return it->second;
+		}
+
+		auto kit = keys.find(v);
+		if (kit == keys.end()) {
+			return NoValue;
+		}
+
+		uint32_t id = value_words.size() / 3;
+		value_words.push_back(std::get<0>(kit->second));
+		value_words.push_back(std::get<1>(kit->second));
+		value_words.push_back(std::get<2>(kit->second));
+		value_ids[v] = id;
+		return id;
+	}
+
+	/// Return NULL if the key does not match any value.
+	Value* resolve(uint32_t kind, uint32_t ordinal, uint32_t operand) {
+		switch (kind) {
+		case ARGUMENT_KEY:
+			return ordinal < args.size() ? args[ordinal] : NULL;
+		case INSTRUCTION_KEY:
+			return ordinal < insts.size() ? insts[ordinal] : NULL;
+		case OPERAND_KEY:
+			if (ordinal >= insts.size() || operand >= insts[ordinal]->getNumOperands()) {
+				return NULL;
+			}
+			return insts[ordinal]->getOperand(operand);
+		default:
+			return NULL;
+		}
+	}
+};
+
+/// Reads the facts of a summary, and fails once the words run out.
+class FactReader {
+private:
+	const uint32_t* words;
+	uint32_t size;
+	uint32_t pos;
+
+public:
+	bool ok;
+
+	FactReader(const uint32_t* w, uint32_t s) :
+			words(w), size(s), pos(0), ok(true) {
+	}
+
+	uint32_t read() {
+		if (pos >= size) {
+			ok = false;
+			return NoValue;
+		}
+		return words[pos++];
+	}
+
+	bool atEnd() const {
+		return pos == size;
+	}
+};
+
+bool isFunctionPointerCast(Value* v) {
+	CastInst* cast = dyn_cast<CastInst>(v);
+	if (cast == NULL) {
+		return false;
+	}
+	Type* origTy = cast->getOperand(0)->getType();
+	Type* castTy = cast->getType();
+	return origTy->isPointerTy() && origTy->getPointerElementType()->isFunctionTy() && castTy->isPointerTy()
+			&& castTy->getPointerElementType()->isFunctionTy();
+}
+
+}
+
+uint64_t DyckSummary::hash(Function* F, uint64_t options) {
+	StructuralHasher hasher(F);
+
+	Fnv f;
+	f.add(Version);
+	f.add(options);
+	f.add(hasher.hashType(F->getFunctionType()));
+	for (Function::iterator bit = F->begin(); bit != F->end(); bit++) {
+		f.add(bit->size());
+		for (BasicBlock::iterator iit = bit->begin(); iit != bit->end(); iit++) {
+			Instruction* inst = iit;
+			f.add(inst->getOpcode());
+			f.add(hasher.hashType(inst->getType()));
+			f.add(inst->getNumOperands());
+			for (unsigned i = 0; i < inst->getNumOperands(); i++) {
+				f.add(hasher.hashOperand(inst->getOperand(i)));
+			}
+
+			if (PHINode* phi = dyn_cast<PHINode>(inst)) {
+				for (unsigned i = 0; i < phi->getNumIncomingValues(); i++) {
+					f.add(hasher.hashOperand(phi->getIncomingBlock(i)));
+				}
+			} else if (ExtractValueInst* ev = dyn_cast<ExtractValueInst>(inst)) {
+				for (auto idx : ev->getIndices()) {
+					f.add(idx);
+				}
+			} else if (InsertValueInst* iv = dyn_cast<InsertValueInst>(inst)) {
+				for (auto idx : iv->getIndices()) {
+					f.add(idx);
+				}
+			} else if (CmpInst* cmp = dyn_cast<CmpInst>(inst)) {
+				f.add(cmp->getPredicate());
+			}
+		}
+	}
+
+	if (!hasher.ok) {
+		return 0;
+	}
+	// 0 means no summary
+	return f.get() ? f.get() : 1;
+}
+
+bool DyckSummary::save(const char* file, Function* F, uint64_t hash, DyckGraph* dg, DyckCallGraphNode* node,
+		EdgeLabel& labels, const vector<Value*>& constants, const vector<Instruction*>& casts,
+		const vector<std::tuple<Function*, Value*, Value*> >& implicitCalls) {
+	LocalNumbering numbering(F, true);
+
+	// the reps in the order of their creation, which is kept when they are loaded
+	vector<DyckVertex*> reps;
+	for (auto v : dg->getVertices()) {
+		if (v != NULL) {
+			reps.push_back(v);
+		}
+	}
+	DenseMap<DyckVertex*, uint32_t> classIds;
+	for (uint32_t c = 0; c < reps.size(); c++) {
+		classIds[reps[c]] = c;
+	}
+
+	// equivalent sets
+	vector<uint32_t> class_offsets;
+	vector<uint32_t> class_values;
+	for (auto rep : reps) {
+		class_offsets.push_back(class_values.size());
+		for (auto val : *rep->getEquivalentSet()) {
+			uint32_t vid = numbering.getOrInsertValue((Value*) val);
+			if (vid == NoValue) {
+				return false;
+			}
+			class_values.push_back(vid);
+		}
+	}
+	class_offsets.push_back(class_values.size());
+
+	// edges
+	map<void*, uint32_t> label_ids;
+	vector<uint32_t> label_words;
+	vector<uint32_t> edge_words;
+	for (uint32_t c = 0; c < reps.size(); c++) {
+		for (auto& out : reps[c]->getOutVertices()) {
+			auto lit = label_ids.find(out.first);
+			if (lit == label_ids.end()) {
+				uint64_t value = (uint64_t) labels.getValue(out.first);
+				lit = label_ids.insert(make_pair(out.first, (uint32_t) label_ids.size())).first;
+				label_words.push_back(EdgeLabel::getLabelTy(out.first));
+				label_words.push_back((uint32_t) value);
+				label_words.push_back((uint32_t) (value >> 32));
+			}
+
+			for (auto tar : out.second) {
+				auto cit = classIds.find(tar);
+				if (cit == classIds.end()) {
+					return false;
+				}
+				edge_words.push_back(c);
+				edge_words.push_back(lit->second);
+				edge_words.push_back(cit->second);
+			}
+		}
+	}
+
+	// the facts: lists of constants, casts, returns, resumes, va_args and inline asms,
+	// each of which is the number of values followed by the values, then the implicit
+	// calls, and then the calls: flags, instruction, called value, number of args, args
+	vector<uint32_t> fact_words;
+	bool ok = true;
+	auto addValue = [&](Value* v) {
+		uint32_t id = numbering.getOrInsertValue(v);
+		ok = ok && (v == NULL || id != NoValue);
+		fact_words.push_back(id);
+	};
+	auto addValues = [&](const vector<Value*>& vals) {
+		fact_words.push_back(vals.size());
+		for (auto v : vals) {
+			addValue(v);
+		}
+	};
+
+	addValues(constants);
+	addValues(vector<Value*>(casts.begin(), casts.end()));
+	addValues(vector<Value*>(node->getReturns().begin(), node->getReturns().end()));
+	addValues(vector<Value*>(node->getResumes().begin(), node->getResumes().end()));
+	addValues(node->getVAArgs());
+	addValues(vector<Value*>(node->getInlineAsms().begin(), node->getInlineAsms().end()));
+
+	fact_words.push_back(implicitCalls.size());
+	for (auto& call : implicitCalls) {
+		addValue(std::get<0>(call));
+		addValue(std::get<1>(call));
+		addValue(std::get<2>(call));
+	}
+
+	vector<pair<Call*, uint32_t> > calls;
+	for (auto call : node->getCommonCalls()) {
+		calls.push_back(make_pair((Call*) call, 0));
+	}
+	for (auto call : node->getPointerCalls()) {
+		calls.push_back(make_pair((Call*) call, POINTER_CALL));
+	}
+	fact_words.push_back(calls.size());
+	for (auto& c : calls) {
+		fact_words.push_back(c.second);
+		addValue(c.first->instruction);
+		addValue(c.first->calledValue);
+		fact_words.push_back(c.first->args.size());
+		for (auto arg : c.first->args) {
+			addValue(arg);
+		}
+	}
+
+	if (!ok) {
+		return false;
+	}
+
+	SummaryHeader header;
+	memcpy(header.magic, SummaryMagic, sizeof(SummaryMagic));
+	header.version = Version;
+	header.hash_low = (uint32_t) hash;
+	header.hash_high = (uint32_t) (hash >> 32);
+	header.num_args = numbering.args.size();
+	header.num_insts = numbering.insts.size();
+	header.num_values = numbering.value_words.size() / 3;
+	header.num_classes = class_offsets.size() - 1;
+	header.num_class_values = class_values.size();
+	header.num_labels = label_words.size() / 3;
+	header.num_edges = edge_words.size() / 3;
+	header.fact_words = fact_words.size();
+
+	// the file is written aside and renamed, so that a reader never sees a partial one
+	int fd;
+	SmallString<128> tmp;
+	if (sys::fs::createUniqueFile(Twine(file) + ".tmp-%%%%%%%%", fd, tmp)) {
+		return false;
+	}
+
+	raw_fd_ostream os(fd, true);
+	os.write((const char*) &header, sizeof(header));
+	const vector<uint32_t>* sections[] = { &numbering.value_words, &class_offsets, &class_values, &label_words,
+			&edge_words, &fact_words };
+	for (auto words : sections) {
+		os.write((const char*) words->data(), words->size() * sizeof(uint32_t));
+	}
+	os.close();
+	if (os.has_error()) {
+		os.clear_error();
+		sys::fs::remove(tmp.str());
+		return false;
+	}
+
+	if (sys::fs::rename(tmp.str(), file)) {
+		sys::fs::remove(tmp.str());
+		return false;
+	}
+	return true;
+}
+
+bool DyckSummary::load(const char* file, Function* F, uint64_t hash, DyckGraph* dg, DyckCallGraphNode* node,
+		EdgeLabel& labels, vector<Value*>& constants, vector<Instruction*>& casts,
+		vector<std::tuple<Function*, Value*, Value*> >& implicitCalls) {
+	ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(file, -1, false);
+	if (!buffer) {
+		return false;
+	}
+
+	const char* data = (*buffer)->getBufferStart();
+	uint64_t size = (*buffer)->getBufferSize();
+
+	// check the header
+	if (size < sizeof(SummaryHeader)) {
+		return false;
+	}
+	const SummaryHeader* header = (const SummaryHeader*) data;
+	if (memcmp(header->magic, SummaryMagic, sizeof(SummaryMagic)) || header->version != Version
+			|| header->hash_low != (uint32_t) hash || header->hash_high != (uint32_t) (hash >> 32)) {
+		return false;
+	}
+
+	uint64_t expected = sizeof(SummaryHeader);
+	expected += 4 * (3 * (uint64_t) header->num_values + header->num_classes + 1 + header->num_class_values);
+	expected += 4 * (3 * (uint64_t) header->num_labels + 3 * (uint64_t) header->num_edges + header->fact_words);
+	if (size != expected) {
+		return false;
+	}
+
+	const uint32_t* value_words = (const uint32_t*) (data + sizeof(SummaryHeader));
+	const uint32_t* class_offsets = value_words + 3 * header->num_values;
+	const uint32_t* class_values = class_offsets + header->num_classes + 1;
+	const uint32_t* label_words = class_values + header->num_class_values;
+	const uint32_t* edge_words = label_words + 3 * header->num_labels;
+	const uint32_t* fact_words = edge_words + 3 * header->num_edges;
+
+	// check the function
+	LocalNumbering numbering(F, false);
+	if (numbering.args.size() != header->num_args || numbering.insts.size() != header->num_insts) {
+		return false;
+	}
+
+	// resolve the values
+	vector<Value*> values(header->num_values, NULL);
+	for (uint32_t i = 0; i < header->num_values; i++) {
+		values[i] = numbering.resolve(value_words[3 * i], value_words[3 * i + 1], value_words[3 * i + 2]);
+		if (values[i] == NULL) {
+			return false;
+		}
+	}
+
+	// check the equivalent sets, the labels and the edges
+	if (class_offsets[0] != 0 || class_offsets[header->num_classes] != header->num_class_values) {
+		return false;
+	}
+	for (uint32_t c = 0; c < header->num_classes; c++) {
+		if (class_offsets[c] > class_offsets[c + 1]) {
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header->num_class_values; i++) {
+		if (class_values[i] >= header->num_values) {
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header->num_labels; i++) {
+		uint32_t kind = label_words[3 * i];
+		if (kind != EdgeLabel::DEREF_TYPE && kind != EdgeLabel::OFFSET_TYPE && kind != EdgeLabel::INDEX_TYPE) {
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header->num_edges; i++) {
+		if (edge_words[3 * i] >= header->num_classes || edge_words[3 * i + 1] >= header->num_labels
+				|| edge_words[3 * i + 2] >= header->num_classes) {
+			return false;
+		}
+	}
+
+	// read the facts, nothing is changed until all of them are checked
+	FactReader reader(fact_words, header->fact_words);
+	auto readValue = [&](bool nullable) -> Value* {
+		uint32_t id = reader.read();
+		if (id == NoValue) {
+			reader.ok = reader.ok && nullable;
+			return NULL;
+		}
+		if (id >= header->num_values) {
+			reader.ok = false;
+			return NULL;
+		}
+		return values[id];
+	};
+	auto readValues = [&](vector<Value*>& vals) {
+		uint32_t num = reader.read();
+		for (uint32_t i = 0; i < num && reader.ok; i++) {
+			vals.push_back(readValue(false));
+		}
+	};
+
+	vector<Value*> constantVals, castVals, retVals, resumeVals, vaargVals, asmVals;
+	readValues(constantVals);
+	readValues(castVals);
+	readValues(retVals);
+	readValues(resumeVals);
+	readValues(vaargVals);
+	readValues(asmVals);
+
+	vector<std::tuple<Function*, Value*, Value*> > implicitVals;
+	uint32_t numImplicitCalls = reader.read();
+	for (uint32_t i = 0; i < numImplicitCalls && reader.ok; i++) {
+		Value* f = readValue(false);
+		Value* cv = readValue(false);
+		Value* arg = readValue(false);
+		reader.ok = reader.ok && isa<Function>(f);
+		if (reader.ok) {
+			implicitVals.push_back(std::make_tuple((Function*) f, cv, arg));
+		}
+	}
+
+	// (flags, instruction, called value, args)
+	vector<std::tuple<uint32_t, Value*, Value*, vector<Value*> > > callVals;
+	uint32_t numCalls = reader.read();
+	for (uint32_t i = 0; i < numCalls && reader.ok; i++) {
+		uint32_t flags = reader.read();
+		Value* inst = readValue(true);
+		Value* cv = readValue(false);
+		reader.ok = reader.ok && (inst == NULL || isa<Instruction>(inst)) && ((flags & POINTER_CALL) || isa<Function>(cv));
+
+		vector<Value*> args;
+		uint32_t numArgs = reader.read();
+		for (uint32_t a = 0; a < numArgs && reader.ok; a++) {
+			args.push_back(readValue(true));
+		}
+		if (reader.ok) {
+			callVals.push_back(std::make_tuple(flags, inst, cv, args));
+		}
+	}
+
+	if (!reader.ok || !reader.atEnd()) {
+		return false;
+	}
+	for (auto v : constantVals) {
+		if (!isa<Constant>(v)) {
+			return false;
+		}
+	}
+	for (auto v : castVals) {
+		if (!isFunctionPointerCast(v)) {
+			return false;
+		}
+	}
+	for (auto v : vaargVals) {
+		if (!isa<VAArgInst>(v)) {
+			return false;
+		}
+	}
+	for (auto v : asmVals) {
+		if (!isa<CallInst>(v) || !((CallInst*) v)->isInlineAsm()) {
+			return false;
+		}
+	}
+
+	// the summary is well-formed, build the graph
+	vector<DyckVertex*> class_vers(header->num_classes, NULL);
+	for (uint32_t c = 0; c < header->num_classes; c++) {
+		DyckVertex* rep = NULL;
+		for (uint32_t i = class_offsets[c]; i < class_offsets[c + 1]; i++) {
+			DyckVertex* ver = dg->retrieveDyckVertex(values[class_values[i]]).first;
+			rep = rep ? dg->combine(rep, ver) : ver;
+		}
+		if (rep == NULL) {
+			rep = dg->retrieveDyckVertex(NULL).first;
+		}
+		class_vers[c] = rep;
+	}
+
+	vector<void*> label_vec(header->num_labels, NULL);
+	for (uint32_t i = 0; i < header->num_labels; i++) {
+		uint64_t value = label_words[3 * i + 1] | ((uint64_t) label_words[3 * i + 2] << 32);
+		label_vec[i] = labels.getOrInsertLabel((EdgeLabel::LABEL_TY) label_words[3 * i], (long) value);
+	}
+
+	for (uint32_t i = 0; i < header->num_edges; i++) {
+		DyckVertex* src = class_vers[edge_words[3 * i]];
+		DyckVertex* dst = class_vers[edge_words[3 * i + 2]];
+		src->addTarget(dst, label_vec[edge_words[3 * i + 1]]);
+	}
+
+	// and what is deferred or recorded in the call graph node
+	constants.insert(constants.end(), constantVals.begin(), constantVals.end());
+	for (auto v : castVals) {
+		casts.push_back((Instruction*) v);
+	}
+	implicitCalls.insert(implicitCalls.end(), implicitVals.begin(), implicitVals.end());
+
+	for (auto v : retVals) {
+		node->addRet(v);
+	}
+	for (auto v : resumeVals) {
+		node->addResume(v);
+	}
+	for (auto v : vaargVals) {
+		node->addVAArg(v);
+	}
+	for (auto v : asmVals) {
+		node->addInlineAsm((CallInst*) v);
+	}
+	for (auto& c : callVals) {
+		Instruction* inst = (Instruction*) std::get<1>(c);
+		if (std::get<0>(c) & POINTER_CALL) {
+			node->addPointerCall(new PointerCall(inst, std::get<2>(c), &std::get<3>(c)));
+		} else {
+			node->addCommonCall(new CommonCall(inst, (Function*) std::get<2>(c), &std::get<3>(c)));
+		}
+	}
+
+	return true;
+}
@@ -4,4 +4,54 @@
  */
 
 #include "DyckAA/EdgeLabel.h"
+#include <assert.h>
+#include <stdio.h>
 
+void* EdgeLabel::getOrInsertLabel(LABEL_TY type, long value) {
+	if (type == DEREF_TYPE) {
+		return getDerefLabel();
+	}
+
+	uint32_t id = (uint32_t) type << KindShift;
+	if (value >= MinInlineValue && value <= MaxInlineValue) {
+		id |= (uint32_t) value & ValueMask;
+	} else {
+		// large offsets are rare, so a linear search is enough
+		std::lock_guard<std::mutex> guard(overflow_mutex);
+		unsigned pos = 0;
+		while (pos < overflow_values.size() && overflow_values[pos] != value) {
+			pos++;
+		}
+		if (pos == overflow_values.size()) {
+			overflow_values.push_back(value);
+		}
+		assert(pos <= ValueMask && "Too many large labels!");
+		id |= OverflowBit | pos;
+	}
+	return (void*) (uintptr_t) id;
+}
+
+long EdgeLabel::getValue(void* label) const {
+	uint32_t id = getId(label);
+	if (id & OverflowBit) {
+		std::lock_guard<std::mutex> guard(overflow_mutex);
+		return overflow_values[id & ValueMask];
+	}
+
+	long value = id & ValueMask;
+	if (value > MaxInlineValue) {
+		// sign extension
+		value -= (long) ValueMask + 1;
+	}
+	return value;
+}
+
+std::string EdgeLabel::getDescription(void* label) const {
+	if (isLabelTy(label, DEREF_TYPE)) {
+		return "D";
+	}
+
+	char temp[32];
+	sprintf(temp, "%c%ld", isLabelTy(label, OFFSET_TYPE) ? '@' : '#', getValue(label));
+	return temp;
+}
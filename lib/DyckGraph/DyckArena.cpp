@@ -0,0 +1,79 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#include "DyckGraph/DyckArena.h"
+#include <assert.h>
+#include <string.h>
+#include <utility>
+
+DyckArena::DyckArena() :
+		cur(NULL), end(NULL), reserved(0), concurrent(false) {
+	memset(free_lists, 0, sizeof(free_lists));
+}
+
+DyckArena::~DyckArena() {
+	for (auto slab : slabs) {
+		free(slab);
+	}
+}
+
+unsigned DyckArena::sizeClass(unsigned long bytes) {
+	unsigned c = MinClass;
+	while ((1UL << c) < bytes) {
+		c++;
+	}
+	assert(c < NumClasses && "The block is too large!");
+	return c;
+}
+
+void DyckArena::swap(DyckArena& other) {
+	for (unsigned c = 0; c < NumClasses; c++) {
+		std::swap(free_lists[c], other.free_lists[c]);
+	}
+	slabs.swap(other.slabs);
+	std::swap(cur, other.cur);
+	std::swap(end, other.end);
+	std::swap(reserved, other.reserved);
+}
+
+void* DyckArena::allocateImpl(unsigned long bytes) {
+	unsigned c = sizeClass(bytes);
+	FreeBlock* block = free_lists[c];
+	if (block) {
+		free_lists[c] = block->next;
+		return block;
+	}
+
+	unsigned long size = 1UL << c;
+	if (size > SlabSize / 4) {
+		// a large block has its own slab, so that the current one is not wasted
+		char* slab = (char*) malloc(size);
+		slabs.push_back(slab);
+		reserved += size;
+		return slab;
+	}
+
+	if (cur + size > end) {
+		cur = (char*) malloc(SlabSize);
+		end = cur + SlabSize;
+		slabs.push_back(cur);
+		reserved += SlabSize;
+	}
+
+	void* ret = cur;
+	cur += size;
+	return ret;
+}
+
+void DyckArena::deallocateImpl(void* p, unsigned long bytes) {
+	if (p == NULL) {
+		return;
+	}
+
+	unsigned c = sizeClass(bytes);
+	FreeBlock* block = (FreeBlock*) p;
+	block->next = free_lists[c];
+	free_lists[c] = block;
+}
@@ -4,10 +4,16 @@
  */
 
 #include "DyckGraph/DyckGraph.h"
+#include "DyckGraph/DyckGraphExporter.h"
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string>
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
 
 // Windows less 'hashtable.h'
 // And the head file is not used ?
@@ -17,75 +23,98 @@
 
 #endif
 
-void DyckGraph::printAsDot(const char* filename) const {
-	FILE * f = fopen(filename, "w+");
-
-	fprintf(f, "digraph ptg {\n");
+void DyckGraph::printAsDot(const char* filename) {
+	DyckGraphExporter exporter(this);
+	exporter.write(filename, DyckGraphExporter::DOT);
+}
 
-	set<DyckVertex*>::iterator vit = vertices.begin();
-	while (vit != vertices.end()) {
-		if ((*vit)->getName() != NULL)
-			fprintf(f, "\ta%d[label=\"%s\"];\n", (*vit)->getIndex(), (*vit)->getName());
-		else
-			fprintf(f, "\ta%d;\n", (*vit)->getIndex());
+void DyckGraph::removeFromWorkList(DyckVertex* v, void* l) {
+	pending.remove(DyckWorkList::key(v->getIndex(), getLabelId(l)));
+}
 
-		map<void*, set<DyckVertex*>>& outs = (*vit)->getOutVertices();
-		map<void*, set<DyckVertex*>>::iterator it = outs.begin();
-		while (it != outs.end()) {
-			long label = (long) (it->first);
-			set<DyckVertex*>* tars = &it->second;
+void DyckGraph::addToWorkList(DyckVertex* v, void* l) {
+	unsigned long long priority = 0;
+	switch (pending.getOrder()) {
+	case DyckWorkList::HIGHEST_DEGREE:
+		priority = v->degree();
+		break;
+	case DyckWorkList::LABEL_PRIORITY:
+		// the smaller the label is, the higher the priority is
+		priority = ~(unsigned long long) (uintptr_t) l;
+		break;
+	case DyckWorkList::FIFO:
+		break;
+	}
+	pending.push(v, l, DyckWorkList::key(v->getIndex(), getLabelId(l)), priority);
+}
 
-			set<DyckVertex*>::iterator tarit = tars->begin();
-			while (tarit != tars->end()) {
-				fprintf(f, "\ta%d->a%d [label=\"%ld\"];\n", (*vit)->getIndex(), (*tarit)->getIndex(), label);
-				tarit++;
-			}
-			it++;
+void DyckGraph::mergeVertices(DyckVertex* x, DyckVertex* y) {
+	assert(x != y);
+	num_merges++;
+	num_edges_moved += y->out_vers.numEdges() + y->in_vers.numEdges();
+
+	// self loops of y become self loops of x
+	vector<void*> selfLoopLabels;
+	DyckEdgeMap& youts = y->getOutVertices();
+	for (auto& yout : youts) {
+		if (yout.second.count(y)) {
+			selfLoopLabels.push_back(yout.first);
 		}
-
-		++vit;
 	}
 
-	fprintf(f, "}\n");
-
-	fclose(f);
-}
+	for (auto label : selfLoopLabels) {
+		if (!x->containsTarget(x, label)) {
+			x->addTarget(x, label);
+		}
+		y->removeTarget(y, label);
+		removeFromWorkList(y, label);
+	}
 
-void DyckGraph::removeFromWorkList(multimap<DyckVertex*, void*>& list, DyckVertex* v, void* l) {
-	typedef multimap<DyckVertex*, void*>::iterator CIT;
-	typedef pair<CIT, CIT> Range;
-	Range range = list.equal_range(v);
-	CIT next = range.first;
-	while (next != range.second) {
-		if ((next)->second == l) {
-			list.erase(next);
-			return;
+	// y's targets become x's targets,
+	// and x is added into the pending pairs by addTarget if necessary
+	DyckEdgeMap outs(std::move(y->out_vers));
+	for (auto& out : outs) {
+		void* label = out.first;
+		// y will have no targets
+		removeFromWorkList(y, label);
+		for (auto w : out.second) {
+			if (!x->containsTarget(w, label)) {
+				x->addTarget(w, label);
+			}
+			// *w remove src y
+			w->removeSource(y, label);
 		}
-		next++;
 	}
-}
 
-bool DyckGraph::containsInWorkList(multimap<DyckVertex*, void*>& list, DyckVertex* v, void* l) {
-	typedef multimap<DyckVertex*, void*>::iterator CIT;
-	typedef pair<CIT, CIT> Range;
-	Range range = list.equal_range(v);
-	CIT next = range.first;
-	while (next != range.second) {
-		if ((next)->second == l) {
-			return true;
+	// y's sources become x's sources
+	DyckEdgeMap ins(std::move(y->in_vers));
+	for (auto& in : ins) {
+		void* label = in.first;
+		for (auto w : in.second) {
+			if (!w->containsTarget(x, label)) {
+				w->addTarget(x, label);
+			}
+			// y has no sources now, so only *w's targets are changed
+			w->removeTarget(y, label);
+			if (w->outNumVertices(label) < 2) {
+				removeFromWorkList(w, label);
+			}
 		}
-		next++;
 	}
-	return false;
+
+	unionVertices(x, y);
+	y->mvEquivalentSetTo(x);
+	deleteDyckVertex(y);
 }
 
 DyckVertex* DyckGraph::combine(DyckVertex* x, DyckVertex* y) {
-	assert(vertices.count(x));
-	assert(vertices.count(y));
+	assert(containsVertex(x));
+	assert(containsVertex(y));
 	
 	if (x == y) {
 		return x;
 	}
+	assert(!compacted && "The graph cannot be changed after compaction!");
 
 	if (x->degree() < y->degree()) {
 		DyckVertex* temp = x;
@@ -93,212 +122,441 @@ DyckVertex* DyckGraph::combine(DyckVertex* x, DyckVertex* y) {
 		y = temp;
 	}
 
-	set<void*>& youtlabels = y->getOutLabels();
-	set<void*>::iterator yolit = youtlabels.begin();
-	while (yolit != youtlabels.end()) {
-		if (y->containsTarget(y, *yolit)) {
-			if (!x->containsTarget(x, *yolit)) {
-				x->addTarget(x, *yolit);
-			}
-			y->removeTarget(y, *yolit);
+	thaw();
+	mergeVertices(x, y);
+	return x;
+}
 
-		}
-		yolit++;
+bool DyckGraph::qirunAlgorithm() {
+	if (num_threads > 1 && pending.size() >= min_parallel_obligations) {
+		return parallelQirunAlgorithm();
 	}
 
-	yolit = youtlabels.begin();
-	while (yolit != youtlabels.end()) {
-		set<DyckVertex*>* ws = &y->getOutVertices()[*yolit];
-		set<DyckVertex*>::iterator w = ws->begin();
-		while (w != ws->end()) {
-			if (!x->containsTarget(*w, *yolit)) {
-				x->addTarget(*w, *yolit);
-				//this->addEdge(x, *w, *yolit);
+	return normalize();
+}
 
-			}
-			// cannot use removeTarget function, which will affect iterator
-			// y remove target *w
-			DyckVertex* wtemp = *w;
-			ws->erase(w++);
-			// *w remove src y
-			((wtemp)->getInVertices())[*yolit].erase(y);
+bool DyckGraph::normalize() {
+	bool ret = true;
+
+	while (!pending.empty()) {
+		DyckVertex* z = NULL;
+		void* label = NULL;
+		unsigned long long key = pending.pop(z, label);
+
+		// z may have been combined into another vertex, or lost its targets
+		if (!isAlive(DyckWorkList::vertexIndex(key)) || z->outNumVertices(label) < 2) {
+			continue;
 		}
-		yolit++;
-	}
 
-	set<void*>& yinlabels = y->getInLabels();
-	set<void*>::iterator yilit = yinlabels.begin();
-	while (yilit != yinlabels.end()) {
-		set<DyckVertex*>* ws = &y->getInVertices()[*yilit];
-		set<DyckVertex*>::iterator w = ws->begin();
-		while (w != ws->end()) {
-			if (!(*w)->containsTarget(x, *yilit)) {
-				(*w)->addTarget(x, *yilit);
-				//this->addEdge(*w, x, *yilit);
-			}
+		if (ret) {
+			ret = false;
+			thaw();
+		}
 
-			// cannot use removeTarget function, which will affect iterator
-			DyckVertex* wtemp = *w;
-			ws->erase(w++);
-			((wtemp)->getOutVertices())[*yilit].erase(y);
+		DyckVertexSet* vers = z->getOutVertices(label);
+		DyckVertexSet::iterator versIt = vers->begin();
+		DyckVertex* x = *(versIt);
+		versIt++;
+		DyckVertex* y = *(versIt);
+		if (x->degree() < y->degree()) {
+			DyckVertex* temp = x;
+			x = y;
+			y = temp;
 		}
+		assert(x != y);
+		mergeVertices(x, y);
 
-		yilit++;
-	}
-//     printf("+++++++++++++++++++++++++++++++++\n");
-	auto vals = y->getEquivalentSet();
-	for (auto& val : *vals) {
-		val_ver_map[val] = x;
-//             printf("+ %d (%p) -> %d (%p)\n", y->getIndex(), val, x->getIndex(), x);
+		// z may still have more than one target
+		if (z != y && z->outNumVertices(label) > 1) {
+			addToWorkList(z, label);
+		}
 	}
-//     printf("+++++++++++++++++++++++++++++++++\n");
-	y->mvEquivalentSetTo(x);
-	vertices.erase(y);
-//     printf("DELETE %d\n", y->getIndex());
-	delete y;
-	return x;
-}
 
-bool DyckGraph::qirunAlgorithm() {
-	bool ret = true;
+	return ret;
+}
 
-	multimap<DyckVertex*, void*> worklist;
+/// Call f(i, t) for each i in [0, n) using at most the given number of threads,
+/// where t is the id of the thread. Items are handed out in chunks.
+template<class F>
+static void parallelFor(size_t n, unsigned threads, F f) {
+	const size_t chunk = 256;
+	if (threads > (n + chunk - 1) / chunk) {
+		threads = (n + chunk - 1) / chunk;
+	}
 
-	set<DyckVertex*>::iterator vit = vertices.begin();
-	while (vit != vertices.end()) {
-		set<void*>& outlabels = (*vit)->getOutLabels();
-		set<void*>::iterator lit = outlabels.begin();
-		while (lit != outlabels.end()) {
-			if ((*vit)->outNumVertices(*lit) > 1) {
-				worklist.insert(pair<DyckVertex*, void*>(*vit, *lit));
-			}
-			lit++;
+	if (threads <= 1) {
+		for (size_t i = 0; i < n; i++) {
+			f(i, 0);
 		}
+		return;
+	}
 
-		vit++;
+	atomic<size_t> next(0);
+	vector<thread> pool;
+	for (unsigned t = 0; t < threads; t++) {
+		pool.push_back(thread([&, t]() {
+			while (true) {
+				size_t begin = next.fetch_add(chunk);
+				if (begin >= n) {
+					break;
+				}
+				size_t end = std::min(n, begin + chunk);
+				for (size_t i = begin; i < end; i++) {
+					f(i, t);
+				}
+			}
+		}));
+	}
+	for (auto& th : pool) {
+		th.join();
 	}
+}
 
-	if (!worklist.empty()) {
-		ret = false;
+/// The lock-free union-find used by parallelQirunAlgorithm(). A root is always
+/// linked to a smaller root, so that no cycle can be formed by concurrent unions.
+/// @{
+static unsigned findRootConcurrently(atomic<unsigned>* parent, unsigned x) {
+	while (true) {
+		unsigned p = parent[x].load();
+		if (p == x) {
+			return x;
+		}
+		unsigned gp = parent[p].load();
+		if (gp != p) {
+			// path halving
+			parent[x].compare_exchange_weak(p, gp);
+		}
+		x = gp;
 	}
+}
 
-	while (!worklist.empty()) {
-		//outs()<<"HERE0\n"; outs().flush();
-		multimap<DyckVertex*, void*>::iterator z_i_it = worklist.begin();
-		//outs()<<"HERE0.1\n"; outs().flush();
-		set<DyckVertex*>* vers = &z_i_it->first->getOutVertices()[z_i_it->second];
-		set<DyckVertex*>::iterator versIt = vers->begin();
-		DyckVertex* x = *(versIt);
-		versIt++;
-		//outs()<<"HERE0.2\n"; outs().flush();
-		DyckVertex* y = *(versIt);
-		if (x->degree() < y->degree()) {
-			DyckVertex* temp = x;
+static void unionConcurrently(atomic<unsigned>* parent, unsigned x, unsigned y) {
+	while (true) {
+		x = findRootConcurrently(parent, x);
+		y = findRootConcurrently(parent, y);
+		if (x == y) {
+			return;
+		}
+		if (x < y) {
+			unsigned temp = x;
 			x = y;
 			y = temp;
 		}
-		//outs()<<"HERE0.3\n"; outs().flush();
-		assert(x != y);
-		vertices.erase(y);
-		auto vals = y->getEquivalentSet();
-		for (auto& val : *vals) {
-			val_ver_map[val] = x;
-		}
-		//outs()<<"HERE0.4\n"; outs().flush();
-		y->mvEquivalentSetTo(x/*->getRepresentative()*/);
-		//outs()<<"HERE1\n"; outs().flush();
-		set<void*>& youtlabels = y->getOutLabels();
-		set<void*>::iterator yolit = youtlabels.begin();
-		while (yolit != youtlabels.end()) {
-			if (y->containsTarget(y, *yolit)) {
-				//if (this->containsEdge(y, y, *yolit)) {
-				if (!x->containsTarget(x, *yolit)) {
-					x->addTarget(x, *yolit);
-					//this->addEdge(x, x, *yolit);
-					if (x->outNumVertices(*yolit) > 1 && !containsInWorkList(worklist, x, *yolit)) {
-						worklist.insert(pair<DyckVertex*, void*>(x, *yolit));
+		unsigned expected = x;
+		if (parent[x].compare_exchange_strong(expected, y)) {
+			return;
+		}
+	}
+}
+/// @}
+
+void DyckGraph::growParallelArrays() {
+	if (par_capacity < next_index) {
+		// the entries are reset between the calls, so the old ones need not be copied
+		par_capacity = std::max(next_index, par_capacity * 2);
+		par_parent.reset(new atomic<unsigned>[par_capacity]);
+		par_affected.reset(new atomic<bool>[par_capacity]);
+		for (unsigned i = 0; i < par_capacity; i++) {
+			par_parent[i].store(i);
+			par_affected[i].store(false);
+		}
+	}
+	par_new_rep_vec.resize(next_index, NULL);
+}
+
+bool DyckGraph::parallelQirunAlgorithm() {
+	bool ret = true;
+	const unsigned threads = num_threads;
+
+	// an entry is changed only for the vertices merged or affected in a round,
+	// and it is reset at the end of the round
+	growParallelArrays();
+	atomic<unsigned>* parent = par_parent.get();
+	atomic<bool>* affected = par_affected.get();
+
+	// vertex index -> the rep it is merged into in the current round
+	vector<DyckVertex*>& new_rep_vec = par_new_rep_vec;
+	auto repOf = [&new_rep_vec](DyckVertex* v) {
+		DyckVertex* r = new_rep_vec[v->getIndex()];
+		return r ? r : v;
+	};
+
+	// only the vertices whose edges were changed in the last round need to be scanned,
+	// which are the vertices of the pending pairs in the first round
+	vector<DyckVertex*> candidates;
+	while (!pending.empty()) {
+		DyckVertex* z = NULL;
+		void* label = NULL;
+		if (isAlive(DyckWorkList::vertexIndex(pending.pop(z, label)))) {
+			candidates.push_back(z);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+	candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+	arena.setConcurrent(true);
+	while (true) {
+		// 1. find the pairs of vertices that must be merged
+		vector<vector<pair<unsigned, unsigned> > > local_pairs(threads);
+		parallelFor(candidates.size(), threads, [&](size_t i, unsigned t) {
+			for (auto& out : candidates[i]->getOutVertices()) {
+				if (out.second.size() > 1) {
+					auto it = out.second.begin();
+					unsigned first = (*it)->getIndex();
+					for (++it; it != out.second.end(); ++it) {
+						local_pairs[t].push_back(make_pair(first, (*it)->getIndex()));
 					}
 				}
-				y->removeTarget(y, *yolit);
-				if (y->outNumVertices(*yolit) < 2) {
-					removeFromWorkList(worklist, y, *yolit);
-				}
 			}
-			yolit++;
-		}
-		//outs()<<"HERE2\n"; outs().flush();
-		yolit = youtlabels.begin();
-		while (yolit != youtlabels.end()) {
-			set<DyckVertex*>* ws = &y->getOutVertices()[*yolit];
-			set<DyckVertex*>::iterator w = ws->begin();
-			while (w != ws->end()) {
-				if (!x->containsTarget(*w, *yolit)) {
-					x->addTarget(*w, *yolit);
-					//this->addEdge(x, *w, *yolit);
-					if (x->outNumVertices(*yolit) > 1 && !containsInWorkList(worklist, x, *yolit)) {
-						worklist.insert(pair<DyckVertex*, void*>(x, *yolit));
+		});
+
+		vector<pair<unsigned, unsigned> > pairs;
+		for (auto& lp : local_pairs) {
+			pairs.insert(pairs.end(), lp.begin(), lp.end());
+		}
+
+		if (pairs.empty()) {
+			break;
+		}
+
+		if (ret) {
+			ret = false;
+			thaw();
+		}
+
+		if (pairs.size() < min_parallel_obligations) {
+			// a few obligations are left, finish them sequentially
+			arena.setConcurrent(false);
+			for (auto v : candidates) {
+				for (auto& out : v->getOutVertices()) {
+					if (out.second.size() > 1) {
+						addToWorkList(v, out.first);
 					}
 				}
-				// cannot use removeTarget function, which will affect iterator
-				// y remove target *w
-				DyckVertex* wtemp = *w;
-				ws->erase(w++);
-				// *w remove src y
-				((wtemp)->getInVertices())[*yolit].erase(y);
-				if (y->outNumVertices(*yolit) < 2) {
-					removeFromWorkList(worklist, y, *yolit);
-				}
+			}
+			normalize();
+			return false;
+		}
+
+		// 2. union them concurrently
+		parallelFor(pairs.size(), threads, [&](size_t i, unsigned) {
+			unionConcurrently(parent, pairs[i].first, pairs[i].second);
+		});
 
-				//w++;
+		// 3. group the merged vertices by their roots
+		vector<pair<unsigned, unsigned> > merged; // (root, index)
+		for (auto& p : pairs) {
+			if (!affected[p.first].exchange(true)) {
+				merged.push_back(make_pair(p.first, p.first));
+			}
+			if (!affected[p.second].exchange(true)) {
+				merged.push_back(make_pair(p.second, p.second));
+			}
+		}
+		parallelFor(merged.size(), threads, [&](size_t i, unsigned) {
+			merged[i].first = findRootConcurrently(parent, merged[i].second);
+		});
+		std::sort(merged.begin(), merged.end());
+
+		vector<unsigned> group_offsets;
+		for (unsigned i = 0; i < merged.size(); i++) {
+			if (i == 0 || merged[i].first != merged[i - 1].first) {
+				group_offsets.push_back(i);
+			}
+		}
+		group_offsets.push_back(merged.size());
+		const unsigned numGroups = group_offsets.size() - 1;
+
+		// like the sequential algorithm, the vertex with the largest degree becomes the rep
+		parallelFor(numGroups, threads, [&](size_t g, unsigned) {
+			DyckVertex* x = NULL;
+			unsigned xdegree = 0;
+			for (unsigned i = group_offsets[g]; i < group_offsets[g + 1]; i++) {
+				DyckVertex* v = vertexAt(merged[i].second);
+				unsigned vdegree = v->degree();
+				if (x == NULL || vdegree > xdegree) {
+					x = v;
+					xdegree = vdegree;
+				}
+			}
+			for (unsigned i = group_offsets[g]; i < group_offsets[g + 1]; i++) {
+				new_rep_vec[merged[i].second] = x;
 			}
-			yolit++;
-		}
-		//outs()<<"HERE3\n"; outs().flush();
-		set<void*>& yinlabels = y->getInLabels();
-		set<void*>::iterator yilit = yinlabels.begin();
-		while (yilit != yinlabels.end()) {
-			set<DyckVertex*>* ws = &y->getInVertices()[*yilit];
-			set<DyckVertex*>::iterator w = ws->begin();
-			while (w != ws->end()) {
-				if (!(*w)->containsTarget(x, *yilit)) {
-					(*w)->addTarget(x, *yilit);
-					//this->addEdge(*w, x, *yilit);
+		});
+
+		// 4. the merged vertices and their neighbors have edges to be redirected
+		vector<vector<DyckVertex*> > local_affected(threads);
+		parallelFor(merged.size(), threads, [&](size_t i, unsigned t) {
+			DyckVertex* v = vertexAt(merged[i].second);
+			local_affected[t].push_back(v);
+			for (auto& out : v->getOutVertices()) {
+				for (auto w : out.second) {
+					if (!affected[w->getIndex()].exchange(true)) {
+						local_affected[t].push_back(w);
+					}
 				}
-
-				// cannot use removeTarget function, which will affect iterator
-				DyckVertex* wtemp = *w;
-				ws->erase(w++);
-				((wtemp)->getOutVertices())[*yilit].erase(y);
-				if ((wtemp)->outNumVertices(*yilit) < 2) {
-					removeFromWorkList(worklist, wtemp, *yilit);
+			}
+			for (auto& in : v->getInVertices()) {
+				for (auto w : in.second) {
+					if (!affected[w->getIndex()].exchange(true)) {
+						local_affected[t].push_back(w);
+					}
 				}
+			}
+		});
+
+		vector<DyckVertex*> affected_vertices;
+		for (auto& la : local_affected) {
+			affected_vertices.insert(affected_vertices.end(), la.begin(), la.end());
+		}
 
-				//w++;
+		// 5. redirect the edges to the reps, each vertex only changes its own edges
+		parallelFor(affected_vertices.size(), threads, [&](size_t i, unsigned) {
+			affected_vertices[i]->getOutVertices().remap(repOf);
+			affected_vertices[i]->getInVertices().remap(repOf);
+		});
+
+		// 6. the rep of each group takes the edges of the others, groups are disjoint
+		vector<unsigned long> local_moved(threads, 0);
+		parallelFor(numGroups, threads, [&](size_t g, unsigned t) {
+			DyckVertex* x = new_rep_vec[merged[group_offsets[g]].second];
+			for (unsigned i = group_offsets[g]; i < group_offsets[g + 1]; i++) {
+				DyckVertex* y = vertexAt(merged[i].second);
+				if (y == x) {
+					continue;
+				}
+				local_moved[t] += y->out_vers.numEdges() + y->in_vers.numEdges();
+				for (auto& out : y->getOutVertices()) {
+					for (auto w : out.second) {
+						x->out_vers.insert(out.first, w);
+					}
+				}
+				for (auto& in : y->getInVertices()) {
+					for (auto w : in.second) {
+						x->in_vers.insert(in.first, w);
+					}
+				}
+				y->out_vers.clear();
+				y->in_vers.clear();
+				y->mvEquivalentSetTo(x);
 			}
+		});
 
-			yilit++;
+		// 7. the surviving vertices are the candidates of the next round
+		candidates.clear();
+		for (auto v : affected_vertices) {
+			if (repOf(v) == v) {
+				candidates.push_back(v);
+			}
+			affected[v->getIndex()].store(false);
 		}
 
-		delete y;
+		for (auto& m : merged) {
+			DyckVertex* y = vertexAt(m.second);
+			DyckVertex* x = new_rep_vec[m.second];
+			parent[m.second].store(m.second);
+			new_rep_vec[m.second] = NULL;
+			if (y != x) {
+				unionVertices(x, y);
+				deleteDyckVertex(y);
+				num_merges++;
+			}
+		}
+		for (auto moved : local_moved) {
+			num_edges_moved += moved;
+		}
 	}
+	arena.setConcurrent(false);
 
 	return ret;
 }
 
+DyckGraph::~DyckGraph() {
+	for (unsigned i = 0; i < next_index; i++) {
+		// the edges and the equivalent sets are released with the arena
+		DyckVertex* v = vertexAt(i);
+		v->abandonArenaMemory();
+		v->~DyckVertex();
+	}
+	for (auto slab : ver_slabs) {
+		free(slab);
+	}
+	delete csr;
+}
+
+DyckVertex* DyckGraph::newDyckVertex(void* value, const char* name) {
+	unsigned index = next_index++;
+	if (index % VerticesPerSlab == 0) {
+		ver_slabs.push_back((DyckVertex*) malloc(sizeof(DyckVertex) * VerticesPerSlab));
+	}
+	DyckVertex* ver = new (ver_slabs.back() + index % VerticesPerSlab) DyckVertex(value, index, this, name);
+	vertices.push_back(ver);
+	num_reps++;
+
+	uf_parent_vec.push_back(index);
+	uf_rank_vec.push_back(0);
+	uf_rep_vec.push_back(ver);
+	return ver;
+}
+
+void DyckGraph::deleteDyckVertex(DyckVertex* v) {
+	// the edges and the equivalent set have been moved to the rep, and the vertex
+	// is destroyed with the graph, so that its index can still be read
+	assert(v->degree() == 0 && v->getEquivalentSetSize() == 0);
+	vertices[v->getIndex()] = NULL;
+	num_reps--;
+}
+
+unsigned DyckGraph::findRoot(unsigned index) {
+	unsigned root = index;
+	while (uf_parent_vec[root] != root) {
+		root = uf_parent_vec[root];
+	}
+
+	// path compression
+	while (uf_parent_vec[index] != root) {
+		unsigned next = uf_parent_vec[index];
+		uf_parent_vec[index] = root;
+		index = next;
+	}
+	return root;
+}
+
+void DyckGraph::unionVertices(DyckVertex* x, DyckVertex* y) {
+	unsigned xroot = findRoot(x->getIndex());
+	unsigned yroot = findRoot(y->getIndex());
+	assert(xroot != yroot);
+
+	// union by rank, the rep of the new root is x anyway
+	if (uf_rank_vec[xroot] < uf_rank_vec[yroot]) {
+		unsigned temp = xroot;
+		xroot = yroot;
+		yroot = temp;
+	} else if (uf_rank_vec[xroot] == uf_rank_vec[yroot]) {
+		uf_rank_vec[xroot]++;
+	}
+
+	uf_parent_vec[yroot] = xroot;
+	uf_rep_vec[xroot] = x;
+	uf_rep_vec[yroot] = NULL;
+
+	if (track_merges) {
+		merge_log.push_back(std::make_pair(x->getIndex(), y->getIndex()));
+	}
+}
+
 pair<DyckVertex*, bool> DyckGraph::retrieveDyckVertex(void* value, const char* name) {
 	if (value == NULL) {
-		DyckVertex* ver = new DyckVertex(NULL);
-		vertices.insert(ver);
+		DyckVertex* ver = newDyckVertex(NULL, NULL);
 		return std::make_pair(ver, false);
 	}
 
 	auto it = val_ver_map.find(value);
 	if (it != val_ver_map.end()) {
-		return std::make_pair(it->second, true);
+		return std::make_pair(uf_rep_vec[findRoot(it->second)], true);
 	} else {
-		DyckVertex* ver = new DyckVertex(value, name);
-		vertices.insert(ver);
-		val_ver_map.insert(pair<void *, DyckVertex*>(value, ver));
+		DyckVertex* ver = newDyckVertex(value, name);
+		val_ver_map.insert(pair<void *, unsigned>(value, ver->getIndex()));
 		return std::make_pair(ver, false);
 	}
 }
@@ -306,36 +564,248 @@ pair<DyckVertex*, bool> DyckGraph::retrieveDyckVertex(void* value, const char* n
 DyckVertex* DyckGraph::findDyckVertex(void* value) {
     auto it = val_ver_map.find(value);
     if (it != val_ver_map.end()) {
-        return it->second;
+        return uf_rep_vec[findRoot(it->second)];
     }
     return NULL;
 }
 
 unsigned int DyckGraph::numVertices() {
-	return vertices.size();
+	return num_reps;
 }
 
 unsigned int DyckGraph::numEquivalentClasses() {
-	return vertices.size();
-}
-
-set<DyckVertex*>& DyckGraph::getVertices() {
-	return vertices;
+	return num_reps;
 }
 
 void DyckGraph::validation(const char* file, int line) {
 	printf("Start validation... ");
-	set<DyckVertex*>& reps = this->getVertices();
-	auto repsIt = reps.begin();
-	while (repsIt != reps.end()) {
-		DyckVertex* rep = *repsIt;
+	for (auto rep : vertices) {
+		if (rep == NULL) {
+			continue;
+		}
 
 		auto repVal = rep->getEquivalentSet();
 		for (auto val : *repVal) {
-			assert(val_ver_map[val] == rep);
+			assert(findDyckVertex(val) == rep);
 		}
-
-		repsIt++;
 	}
 	printf("Done!\n\n");
 }
+
+unsigned DyckGraph::getLabelId(void* label) {
+	auto it = label_id_map.find(label);
+	if (it != label_id_map.end()) {
+		return it->second;
+	}
+
+	unsigned id = id_label_vec.size();
+	id_label_vec.push_back(label);
+	label_id_map.insert(pair<void*, unsigned>(label, id));
+	return id;
+}
+
+const unsigned DyckCSR::InvalidId;
+
+void DyckGraph::freeze() {
+	thaw();
+	csr = new DyckCSR;
+
+	// the reps are numbered in the order of their creation rather than by their
+	// addresses, so that the ids, and the exported graph, are the same in every run
+	unsigned numVers = num_reps;
+	csr->id_ver_vec.reserve(numVers);
+	csr->index_id_vec.resize(next_index, DyckCSR::InvalidId);
+	for (auto v : vertices) {
+		if (v != NULL) {
+			csr->index_id_vec[v->getIndex()] = csr->id_ver_vec.size();
+			csr->id_ver_vec.push_back(v);
+		}
+	}
+
+	// (label id, vertex id) pairs of a vertex, which are sorted before
+	// being copied into the csr
+	vector<pair<unsigned, unsigned>> edges;
+	auto fillEdges = [this, &edges](DyckEdgeMap& adj, vector<unsigned>& offsets,
+			vector<unsigned>& labels, vector<unsigned>& vers) {
+		edges.clear();
+		for (auto& e : adj) {
+			unsigned lid = getLabelId(e.first);
+			for (auto w : e.second) {
+				edges.push_back(pair<unsigned, unsigned>(lid, csr->getId(w)));
+			}
+		}
+		sort(edges.begin(), edges.end());
+		for (auto& e : edges) {
+			labels.push_back(e.first);
+			vers.push_back(e.second);
+		}
+		offsets.push_back(vers.size());
+	};
+
+	csr->out_offsets.reserve(numVers + 1);
+	csr->in_offsets.reserve(numVers + 1);
+	csr->out_offsets.push_back(0);
+	csr->in_offsets.push_back(0);
+	for (auto v : csr->id_ver_vec) {
+		fillEdges(v->getOutVertices(), csr->out_offsets, csr->out_labels, csr->out_targets);
+		fillEdges(v->getInVertices(), csr->in_offsets, csr->in_labels, csr->in_sources);
+	}
+}
+
+/// Order the vertices of the csr in reverse Cuthill-McKee order, treating the
+/// edges as undirected. Return the old ids in the new order.
+static vector<unsigned> reverseCuthillMcKee(DyckCSR* csr) {
+	unsigned numVers = csr->numVertices();
+	vector<unsigned> degrees(numVers);
+	vector<unsigned> byDegree(numVers);
+	for (unsigned i = 0; i < numVers; i++) {
+		degrees[i] = csr->outEnd(i) - csr->outBegin(i) + csr->inEnd(i) - csr->inBegin(i);
+		byDegree[i] = i;
+	}
+	auto lessDegree = [&degrees](unsigned a, unsigned b) {
+		return degrees[a] < degrees[b] || (degrees[a] == degrees[b] && a < b);
+	};
+	sort(byDegree.begin(), byDegree.end(), lessDegree);
+
+	// each component is visited in BFS order from its vertex of the minimum degree,
+	// and the neighbors of a vertex are visited by their degrees
+	vector<bool> visited(numVers, false);
+	vector<unsigned> order;
+	order.reserve(numVers);
+	for (auto start : byDegree) {
+		if (visited[start]) {
+			continue;
+		}
+		visited[start] = true;
+		order.push_back(start);
+
+		for (size_t head = order.size() - 1; head < order.size(); head++) {
+			unsigned v = order[head];
+			size_t first = order.size();
+			for (unsigned e = csr->outBegin(v); e < csr->outEnd(v); e++) {
+				unsigned w = csr->outTarget(e);
+				if (!visited[w]) {
+					visited[w] = true;
+					order.push_back(w);
+				}
+			}
+			for (unsigned e = csr->inBegin(v); e < csr->inEnd(v); e++) {
+				unsigned w = csr->inSource(e);
+				if (!visited[w]) {
+					visited[w] = true;
+					order.push_back(w);
+				}
+			}
+			sort(order.begin() + first, order.end(), lessDegree);
+		}
+	}
+
+	reverse(order.begin(), order.end());
+	return order;
+}
+
+void DyckGraph::renumberCSR(const vector<unsigned>& order) {
+	DyckCSR* old = csr;
+	csr = new DyckCSR;
+
+	unsigned numVers = order.size();
+	csr->id_ver_vec.reserve(numVers);
+	csr->index_id_vec.resize(next_index, DyckCSR::InvalidId);
+	for (auto oldId : order) {
+		DyckVertex* v = old->getVertex(oldId);
+		csr->index_id_vec[v->getIndex()] = csr->id_ver_vec.size();
+		csr->id_ver_vec.push_back(v);
+	}
+
+	csr->out_offsets.reserve(numVers + 1);
+	csr->out_labels.reserve(old->numEdges());
+	csr->out_targets.reserve(old->numEdges());
+	csr->out_offsets.push_back(0);
+	vector<pair<unsigned, unsigned>> edges;
+	for (auto oldId : order) {
+		edges.clear();
+		for (unsigned e = old->outBegin(oldId); e < old->outEnd(oldId); e++) {
+			edges.push_back(pair<unsigned, unsigned>(old->outLabel(e), csr->getId(old->getVertex(old->outTarget(e)))));
+		}
+		sort(edges.begin(), edges.end());
+		for (auto& e : edges) {
+			csr->out_labels.push_back(e.first);
+			csr->out_targets.push_back(e.second);
+		}
+		csr->out_offsets.push_back(csr->out_targets.size());
+	}
+
+	// no in edges
+	csr->in_offsets.assign(numVers + 1, 0);
+	delete old;
+}
+
+void DyckGraph::compact() {
+	if (compacted) {
+		return;
+	}
+
+	// edges may have been added after the graph was frozen
+	freeze();
+	renumberCSR(reverseCuthillMcKee(csr));
+
+	// the memory of the vertices is copied into the new arena in the order of
+	// the csr, and the old arena is released with the sources of the vertices
+	DyckArena old;
+	old.swap(arena);
+	for (unsigned i = 0; i < csr->numVertices(); i++) {
+		csr->getVertex(i)->compact();
+	}
+
+	pending = DyckWorkList();
+	vertices.shrink_to_fit();
+	uf_parent_vec.shrink_to_fit();
+	uf_rank_vec.shrink_to_fit();
+	uf_rep_vec.shrink_to_fit();
+	id_label_vec.shrink_to_fit();
+	val_ver_map.rehash(0);
+	compacted = true;
+}
+
+void DyckGraph::thaw() {
+	delete csr;
+	csr = NULL;
+}
+
+unsigned long DyckCSR::getMemoryUsage() const {
+	unsigned long ret = sizeof(DyckCSR);
+	ret += id_ver_vec.capacity() * sizeof(DyckVertex*);
+	ret += index_id_vec.capacity() * sizeof(unsigned);
+	ret += (out_offsets.capacity() + out_labels.capacity() + out_targets.capacity()) * sizeof(unsigned);
+	ret += (in_offsets.capacity() + in_labels.capacity() + in_sources.capacity()) * sizeof(unsigned);
+	return ret;
+}
+
+unsigned long DyckGraph::getMemoryUsage() {
+	unsigned long ret = sizeof(DyckGraph);
+	ret += ver_slabs.size() * VerticesPerSlab * sizeof(DyckVertex) + arena.getMemoryUsage();
+	ret += vertices.capacity() * sizeof(DyckVertex*);
+	// a node of std::unordered_map<void*, unsigned> costs about 32 bytes
+	ret += val_ver_map.size() * 32 + val_ver_map.bucket_count() * sizeof(void*);
+	ret += uf_parent_vec.capacity() * sizeof(unsigned) + uf_rank_vec.capacity() + uf_rep_vec.capacity() * sizeof(DyckVertex*);
+	if (csr) {
+		ret += csr->getMemoryUsage();
+	}
+	return ret;
+}
+
+void DyckGraph::printMemoryUsage() {
+	unsigned long numEdges = 0;
+	unsigned long numLabels = 0;
+	for (auto v : vertices) {
+		if (v != NULL) {
+			numEdges += v->getOutVertices().numEdges();
+			numLabels += v->getOutVertices().size();
+		}
+	}
+
+	printf("# Vertices: %u\n", num_reps);
+	printf("# Edges: %lu\n", numEdges);
+	printf("# (Vertex, Label) Pairs: %lu\n", numLabels);
+	printf("Memory: %lu KB\n", getMemoryUsage() / 1024);
+}
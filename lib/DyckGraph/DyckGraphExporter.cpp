@@ -0,0 +1,272 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#include "DyckGraph/DyckGraphExporter.h"
+#include <stdio.h>
+#include <algorithm>
+#include <thread>
+
+/// the number of vertices formatted before a buffer is written
+static const unsigned VerticesPerBlock = 1 << 16;
+
+static void appendUInt(string& buf, unsigned n) {
+	char digits[16];
+	int len = 0;
+	do {
+		digits[len++] = '0' + n % 10;
+		n /= 10;
+	} while (n);
+	while (len) {
+		buf.push_back(digits[--len]);
+	}
+}
+
+static void appendWord(string& buf, uint32_t w) {
+	buf.append((const char*) &w, sizeof(uint32_t));
+}
+
+/// Escape the characters that cannot appear in a quoted string of dot.
+static string escapeDot(const string& s) {
+	string ret;
+	for (char c : s) {
+		if (c == '"' || c == '\\') {
+			ret.push_back('\\');
+		}
+		ret.push_back(c);
+	}
+	return ret;
+}
+
+static string escapeXML(const string& s) {
+	string ret;
+	for (char c : s) {
+		switch (c) {
+		case '&':
+			ret += "&amp;";
+			break;
+		case '<':
+			ret += "&lt;";
+			break;
+		case '>':
+			ret += "&gt;";
+			break;
+		case '"':
+			ret += "&quot;";
+			break;
+		default:
+			ret.push_back(c);
+			break;
+		}
+	}
+	return ret;
+}
+
+DyckGraphExporter::DyckGraphExporter(DyckGraph* dg) :
+		graph(dg), num_threads(1) {
+	if (dg->getCSR() == NULL) {
+		dg->freeze();
+	}
+	csr = dg->getCSR();
+	highlighted.resize(csr->numVertices(), false);
+
+	setLabelDescription([](void* label) {
+		char desc[32];
+		snprintf(desc, sizeof(desc), "%ld", (long) label);
+		return string(desc);
+	});
+}
+
+void DyckGraphExporter::setLabelDescription(function<string(void*)> desc) {
+	unsigned numLabels = graph->numLabels();
+	label_descs.resize(numLabels);
+	for (unsigned i = 0; i < numLabels; i++) {
+		label_descs[i] = desc(graph->getLabel(i));
+	}
+}
+
+void DyckGraphExporter::setHighlighted(const set<DyckVertex*>& vers) {
+	for (auto v : vers) {
+		unsigned id = csr->getId(v);
+		if (id != DyckCSR::InvalidId) {
+			highlighted[id] = true;
+		}
+	}
+}
+
+void DyckGraphExporter::formatHeader(string& buf, Format format) {
+	switch (format) {
+	case DOT:
+		buf += "digraph rel{\n";
+		break;
+	case GRAPHML:
+		buf += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+		buf += "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n";
+		buf += "<key id=\"name\" for=\"node\" attr.name=\"name\" attr.type=\"string\"/>\n";
+		buf += "<key id=\"highlighted\" for=\"node\" attr.name=\"highlighted\" attr.type=\"boolean\"/>\n";
+		buf += "<key id=\"label\" for=\"edge\" attr.name=\"label\" attr.type=\"string\"/>\n";
+		buf += "<graph id=\"dyck\" edgedefault=\"directed\">\n";
+		break;
+	case EDGE_LIST: {
+		vector<unsigned> highlightedIds;
+		for (unsigned i = 0; i < highlighted.size(); i++) {
+			if (highlighted[i]) {
+				highlightedIds.push_back(i);
+			}
+		}
+
+		appendWord(buf, EdgeListMagic);
+		appendWord(buf, EdgeListVersion);
+		appendWord(buf, csr->numVertices());
+		appendWord(buf, label_descs.size());
+		appendWord(buf, highlightedIds.size());
+		appendWord(buf, csr->numEdges());
+		for (auto& desc : label_descs) {
+			appendWord(buf, desc.size());
+			buf += desc;
+			buf.append((4 - desc.size() % 4) % 4, '\0');
+		}
+		for (auto id : highlightedIds) {
+			appendWord(buf, id);
+		}
+		break;
+	}
+	}
+}
+
+void DyckGraphExporter::formatFooter(string& buf, Format format) {
+	switch (format) {
+	case DOT:
+		buf += "}\n";
+		break;
+	case GRAPHML:
+		buf += "</graph>\n</graphml>\n";
+		break;
+	case EDGE_LIST:
+		break;
+	}
+}
+
+void DyckGraphExporter::formatVertices(string& buf, unsigned begin, unsigned end, Format format) {
+	for (unsigned id = begin; id < end; id++) {
+		const char* name = csr->getVertex(id)->getName();
+		switch (format) {
+		case DOT:
+			buf += 'a';
+			appendUInt(buf, id + 1);
+			buf += "[label=";
+			if (name != NULL) {
+				buf += '"';
+				buf += escapeDot(name);
+				buf += '"';
+			} else {
+				appendUInt(buf, id + 1);
+			}
+			buf += highlighted[id] ? " color=red];\n" : "];\n";
+			break;
+		case GRAPHML:
+			buf += "<node id=\"a";
+			appendUInt(buf, id + 1);
+			buf += "\">";
+			if (name != NULL) {
+				buf += "<data key=\"name\">";
+				buf += escapeXML(name);
+				buf += "</data>";
+			}
+			if (highlighted[id]) {
+				buf += "<data key=\"highlighted\">true</data>";
+			}
+			buf += "</node>\n";
+			break;
+		case EDGE_LIST:
+			break;
+		}
+	}
+}
+
+void DyckGraphExporter::formatEdges(string& buf, unsigned begin, unsigned end, Format format) {
+	for (unsigned id = begin; id < end; id++) {
+		for (unsigned e = csr->outBegin(id); e < csr->outEnd(id); e++) {
+			unsigned label = csr->outLabel(e);
+			unsigned target = csr->outTarget(e);
+			switch (format) {
+			case DOT:
+				buf += 'a';
+				appendUInt(buf, id + 1);
+				buf += "->a";
+				appendUInt(buf, target + 1);
+				buf += "[label=\"";
+				buf += escapeDot(label_descs[label]);
+				buf += highlighted[id] && highlighted[target] ? "\" color=red];\n" : "\"];\n";
+				break;
+			case GRAPHML:
+				buf += "<edge source=\"a";
+				appendUInt(buf, id + 1);
+				buf += "\" target=\"a";
+				appendUInt(buf, target + 1);
+				buf += "\"><data key=\"label\">";
+				buf += escapeXML(label_descs[label]);
+				buf += "</data></edge>\n";
+				break;
+			case EDGE_LIST:
+				appendWord(buf, id);
+				appendWord(buf, label);
+				appendWord(buf, target);
+				break;
+			}
+		}
+	}
+}
+
+bool DyckGraphExporter::write(const char* file, Format format) {
+	FILE* f = fopen(file, format == EDGE_LIST ? "wb" : "w");
+	if (f == NULL) {
+		return false;
+	}
+
+	vector<string> bufs(num_threads);
+	formatHeader(bufs[0], format);
+	bool ok = fwrite(bufs[0].data(), 1, bufs[0].size(), f) == bufs[0].size();
+
+	unsigned numVers = csr->numVertices();
+	for (unsigned block = 0; ok && block < numVers; block += VerticesPerBlock) {
+		unsigned blockEnd = std::min(numVers, block + VerticesPerBlock);
+
+		// the vertices of a block are printed before their edges
+		for (int pass = 0; pass < 2; pass++) {
+			// each thread formats a contiguous shard of the block into its own buffer,
+			// and the buffers are written in order
+			auto formatShard = [this, &bufs, pass, format](unsigned t, unsigned begin, unsigned end) {
+				bufs[t].clear();
+				if (pass == 0) {
+					formatVertices(bufs[t], begin, end, format);
+				} else {
+					formatEdges(bufs[t], begin, end, format);
+				}
+			};
+
+			unsigned shard = (blockEnd - block + num_threads - 1) / num_threads;
+			vector<thread> pool;
+			for (unsigned t = 1; t < num_threads; t++) {
+				unsigned begin = std::min(blockEnd, block + t * shard);
+				unsigned end = std::min(blockEnd, begin + shard);
+				pool.push_back(thread(formatShard, t, begin, end));
+			}
+			formatShard(0, block, std::min(blockEnd, block + shard));
+			for (auto& th : pool) {
+				th.join();
+			}
+
+			for (auto& buf : bufs) {
+				ok = ok && fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+			}
+		}
+	}
+
+	bufs[0].clear();
+	formatFooter(bufs[0], format);
+	ok = ok && fwrite(bufs[0].data(), 1, bufs[0].size(), f) == bufs[0].size();
+
+	return fclose(f) == 0 && ok;
+}
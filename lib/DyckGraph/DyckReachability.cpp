@@ -0,0 +1,207 @@
+/*
+ * Developed by Qingkai Shi
+ * Copy Right by Prism Research Group, HKUST and State Key Lab for Novel Software Tech., Nanjing University.  
+ */
+
+#include "DyckGraph/DyckReachability.h"
+#include <assert.h>
+#include <algorithm>
+
+DyckReachability::DyckReachability(DyckCSR* c, const vector<bool>& labels) :
+		csr(c), forest(true), visit_stamp(0) {
+	condense(labels);
+	computeIntervals();
+	visit_marks.resize(numComponents(), 0);
+}
+
+void DyckReachability::condense(const vector<bool>& labels) {
+	unsigned numVers = csr->numVertices();
+	const unsigned Unvisited = ~0u;
+
+	auto considered = [this, &labels](unsigned e) {
+		unsigned label = csr->outLabel(e);
+		return label < labels.size() && labels[label];
+	};
+
+	comp_vec.assign(numVers, Unvisited);
+	vector<unsigned> order(numVers, Unvisited);
+	vector<unsigned> lowlink(numVers, 0);
+	vector<bool> onStack(numVers, false);
+	vector<unsigned> sccStack;
+	// (vertex, the next out edge to visit)
+	vector<pair<unsigned, unsigned> > dfsStack;
+	unsigned nextOrder = 0;
+	unsigned numComps = 0;
+
+	for (unsigned root = 0; root < numVers; root++) {
+		if (order[root] != Unvisited) {
+			continue;
+		}
+
+		order[root] = lowlink[root] = nextOrder++;
+		sccStack.push_back(root);
+		onStack[root] = true;
+		dfsStack.push_back(make_pair(root, csr->outBegin(root)));
+
+		while (!dfsStack.empty()) {
+			unsigned v = dfsStack.back().first;
+			unsigned& e = dfsStack.back().second;
+
+			if (e != csr->outEnd(v)) {
+				unsigned w = csr->outTarget(e);
+				bool visit = considered(e);
+				e++;
+				if (!visit) {
+					continue;
+				}
+
+				if (order[w] == Unvisited) {
+					order[w] = lowlink[w] = nextOrder++;
+					sccStack.push_back(w);
+					onStack[w] = true;
+					dfsStack.push_back(make_pair(w, csr->outBegin(w)));
+				} else if (onStack[w]) {
+					lowlink[v] = std::min(lowlink[v], order[w]);
+				}
+				continue;
+			}
+
+			// all the out edges of v are visited
+			dfsStack.pop_back();
+			if (!dfsStack.empty()) {
+				unsigned parent = dfsStack.back().first;
+				lowlink[parent] = std::min(lowlink[parent], lowlink[v]);
+			}
+
+			if (lowlink[v] == order[v]) {
+				unsigned w;
+				do {
+					w = sccStack.back();
+					sccStack.pop_back();
+					onStack[w] = false;
+					comp_vec[w] = numComps;
+				} while (w != v);
+				numComps++;
+			}
+		}
+	}
+
+	// the edges among the components without duplicates
+	vector<vector<unsigned> > succs(numComps);
+	for (unsigned v = 0; v < numVers; v++) {
+		for (unsigned e = csr->outBegin(v); e != csr->outEnd(v); e++) {
+			if (considered(e) && comp_vec[csr->outTarget(e)] != comp_vec[v]) {
+				succs[comp_vec[v]].push_back(comp_vec[csr->outTarget(e)]);
+			}
+		}
+	}
+
+	comp_offsets.resize(numComps + 1);
+	comp_offsets[0] = 0;
+	vector<unsigned> numPreds(numComps, 0);
+	for (unsigned c = 0; c < numComps; c++) {
+		vector<unsigned>& s = succs[c];
+		std::sort(s.begin(), s.end());
+		s.erase(std::unique(s.begin(), s.end()), s.end());
+		for (auto t : s) {
+			comp_targets.push_back(t);
+			if (++numPreds[t] > 1) {
+				forest = false;
+			}
+		}
+		comp_offsets[c + 1] = comp_targets.size();
+		vector<unsigned>().swap(s);
+	}
+}
+
+void DyckReachability::computeIntervals() {
+	unsigned numComps = comp_offsets.size() - 1;
+	const unsigned Unvisited = ~0u;
+
+	low_vec.assign(numComps, Unvisited);
+	post_vec.assign(numComps, Unvisited);
+
+	// a component only has edges to the ones with smaller numbers, so the DFS
+	// starts from the larger ones, which include all the components without predecessors
+	vector<pair<unsigned, unsigned> > dfsStack;
+	unsigned nextPost = 0;
+	for (unsigned root = numComps; root-- > 0;) {
+		if (post_vec[root] != Unvisited || low_vec[root] != Unvisited) {
+			continue;
+		}
+
+		// low_vec marks the components on the stack before they get their intervals
+		low_vec[root] = nextPost;
+		dfsStack.push_back(make_pair(root, comp_offsets[root]));
+		while (!dfsStack.empty()) {
+			unsigned c = dfsStack.back().first;
+			unsigned& e = dfsStack.back().second;
+
+			if (e != comp_offsets[c + 1]) {
+				unsigned t = comp_targets[e++];
+				if (low_vec[t] == Unvisited) {
+					low_vec[t] = nextPost;
+					dfsStack.push_back(make_pair(t, comp_offsets[t]));
+				}
+				continue;
+			}
+
+			dfsStack.pop_back();
+			post_vec[c] = nextPost++;
+			// the lowest post number of the components c reaches
+			unsigned low = post_vec[c];
+			for (unsigned i = comp_offsets[c]; i != comp_offsets[c + 1]; i++) {
+				low = std::min(low, low_vec[comp_targets[i]]);
+			}
+			low_vec[c] = low;
+		}
+	}
+}
+
+bool DyckReachability::reachable(unsigned from, unsigned to) {
+	unsigned cfrom = comp_vec[from];
+	unsigned cto = comp_vec[to];
+
+	assert(from != to);
+	if (cfrom == cto) {
+		return true;
+	}
+
+	if (!contains(cfrom, cto)) {
+		return false;
+	}
+	if (forest) {
+		return true;
+	}
+
+	uint64_t key = ((uint64_t) cfrom << 32) | cto;
+	auto it = cache.find(key);
+	if (it != cache.end()) {
+		return it->second;
+	}
+
+	// only the components whose intervals contain the target can reach it
+	bool ret = false;
+	visit_stamp++;
+	vector<unsigned> workStack;
+	workStack.push_back(cfrom);
+	visit_marks[cfrom] = visit_stamp;
+	while (!workStack.empty() && !ret) {
+		unsigned c = workStack.back();
+		workStack.pop_back();
+		for (unsigned i = comp_offsets[c]; i != comp_offsets[c + 1]; i++) {
+			unsigned t = comp_targets[i];
+			if (t == cto) {
+				ret = true;
+				break;
+			}
+			if (visit_marks[t] != visit_stamp && contains(t, cto)) {
+				visit_marks[t] = visit_stamp;
+				workStack.push_back(t);
+			}
+		}
+	}
+
+	cache[key] = ret;
+	return ret;
+}
@@ -4,20 +4,65 @@
  */
 
 #include "DyckGraph/DyckVertex.h"
+#include "DyckGraph/DyckGraph.h"
 #include <assert.h>
+#include <algorithm>
+#include <vector>
 
-int DyckVertex::global_indx = 0;
-
-DyckVertex::DyckVertex(void * v, const char * itsname) {
+DyckVertex::DyckVertex(void * v, unsigned idx, DyckGraph* g, const char * itsname) :
+		graph(g), in_vers(&g->arena), out_vers(&g->arena), equiv_head(NULL), equiv_tail(NULL), equiv_size(0), equiv_cache(NULL) {
 	name = itsname;
-	index = global_indx++;
+	index = idx;
 
 	if (v != NULL) {
-		equivclass.insert(v);
+		EquivNode* node = (EquivNode*) DyckArena::allocate(&g->arena, sizeof(EquivNode));
+		node->value = v;
+		node->next = NULL;
+		equiv_head = equiv_tail = node;
+		equiv_size = 1;
 	}
 }
 
 DyckVertex::~DyckVertex() {
+	DyckArena* arena = in_vers.getArena();
+	EquivNode* node = equiv_head;
+	while (node != NULL) {
+		EquivNode* next = node->next;
+		DyckArena::deallocate(arena, node, sizeof(EquivNode));
+		node = next;
+	}
+	delete equiv_cache;
+}
+
+void DyckVertex::abandonArenaMemory() {
+	in_vers.abandon();
+	out_vers.abandon();
+	equiv_head = equiv_tail = NULL;
+	equiv_size = 0;
+}
+
+void DyckVertex::compact() {
+	in_vers.abandon();
+	out_vers.relocate();
+	name = NULL;
+
+	DyckArena* arena = out_vers.getArena();
+	EquivNode* node = equiv_head;
+	EquivNode* prev = NULL;
+	equiv_head = NULL;
+	while (node != NULL) {
+		EquivNode* copy = (EquivNode*) DyckArena::allocate(arena, sizeof(EquivNode));
+		copy->value = node->value;
+		copy->next = NULL;
+		if (prev == NULL) {
+			equiv_head = copy;
+		} else {
+			prev->next = copy;
+		}
+		prev = copy;
+		node = node->next;
+	}
+	equiv_tail = prev;
 }
 
 const char * DyckVertex::getName() {
@@ -41,25 +86,25 @@ unsigned int DyckVertex::inNumVertices(void* label) {
 }
 
 unsigned int DyckVertex::degree() {
-	unsigned int ret = 0;
-
-	map<void*, set<DyckVertex*>>::iterator iit = in_vers.begin();
-	while (iit != in_vers.end()) {
-		ret = ret + iit->second.size();
-		iit++;
-	}
+	return in_vers.numEdges() + out_vers.numEdges();
+}
 
-	map<void*, set<DyckVertex*>>::iterator oit = out_vers.begin();
-	while (oit != out_vers.end()) {
-		ret = ret + oit->second.size();
-		oit++;
+set<void*>* DyckVertex::getEquivalentSet() {
+	if (equiv_cache == NULL) {
+		vector<void*> values;
+		values.reserve(equiv_size);
+		for (EquivNode* node = equiv_head; node != NULL; node = node->next) {
+			values.push_back(node->value);
+		}
+		std::sort(values.begin(), values.end());
+		// the values are sorted, so the set is built in linear time
+		equiv_cache = new set<void*>(values.begin(), values.end());
 	}
-
-	return ret;
+	return equiv_cache;
 }
 
-set<void*>* DyckVertex::getEquivalentSet() {
-	return &this->equivclass;
+unsigned DyckVertex::getEquivalentSetSize() {
+	return equiv_size;
 }
 
 void DyckVertex::mvEquivalentSetTo(DyckVertex* rootRep) {
@@ -67,44 +112,53 @@ void DyckVertex::mvEquivalentSetTo(DyckVertex* rootRep) {
 		return;
 	}
 
-	set<void*>* rootecls = rootRep->getEquivalentSet();
-	set<void*>* thisecls = this->getEquivalentSet();
+	if (equiv_head != NULL) {
+		if (rootRep->equiv_head == NULL) {
+			rootRep->equiv_head = equiv_head;
+		} else {
+			rootRep->equiv_tail->next = equiv_head;
+		}
+		rootRep->equiv_tail = equiv_tail;
+		rootRep->equiv_size += equiv_size;
 
-	rootecls->insert(thisecls->begin(), thisecls->end());
-}
+		equiv_head = equiv_tail = NULL;
+		equiv_size = 0;
 
-set<void*>& DyckVertex::getOutLabels() {
-	return out_lables;
-}
+		delete rootRep->equiv_cache;
+		rootRep->equiv_cache = NULL;
+	}
 
-map<void*, set<DyckVertex*>>& DyckVertex::getOutVertices() {
-	return out_vers;
+	delete equiv_cache;
+	equiv_cache = NULL;
 }
 
-set<void*>& DyckVertex::getInLabels() {
-	return in_lables;
+DyckEdgeMap& DyckVertex::getOutVertices() {
+	return out_vers;
 }
 
-map<void*, set<DyckVertex*>>& DyckVertex::getInVertices() {
+DyckEdgeMap& DyckVertex::getInVertices() {
 	return in_vers;
 }
 
-int DyckVertex::getIndex() {
+unsigned DyckVertex::getIndex() {
 	return index;
 }
 
+unsigned long DyckVertex::getMemoryUsage() {
+	return sizeof(DyckVertex) + in_vers.heapBytes() + out_vers.heapBytes() + equiv_size * sizeof(EquivNode);
+}
+
 void DyckVertex::addTarget(DyckVertex* ver, void* label) {
-	out_lables.insert(label);
-	out_vers[label].insert(ver);
+	assert(!graph->isCompacted() && "The graph cannot be changed after compaction!");
+	if (out_vers.insert(label, ver) && outNumVertices(label) > 1) {
+		graph->addToWorkList(this, label);
+	}
 
 	ver->addSource(this, label);
 }
 
 void DyckVertex::removeTarget(DyckVertex* ver, void* label) {
-    auto it = out_vers.find(label);
-    if (it != out_vers.end()) {
-        it->second.erase(ver);
-    }
+	out_vers.erase(label, ver);
 
 	ver->removeSource(this, label);
 }
@@ -118,7 +172,7 @@ bool DyckVertex::containsTarget(DyckVertex* tar, void* label) {
     return false;
 }
 
-set<DyckVertex*>* DyckVertex::getInVertices(void * label) {
+DyckVertexSet* DyckVertex::getInVertices(void * label) {
     auto it = in_vers.find(label);
     if (it != in_vers.end()) {
         return &it->second;
@@ -126,7 +180,7 @@ set<DyckVertex*>* DyckVertex::getInVertices(void * label) {
     return nullptr;
 }
 
-set<DyckVertex*>* DyckVertex::getOutVertices(void * label) {
+DyckVertexSet* DyckVertex::getOutVertices(void * label) {
     auto it = out_vers.find(label);
     if (it != out_vers.end()) {
         return &it->second;
@@ -137,13 +191,9 @@ set<DyckVertex*>* DyckVertex::getOutVertices(void * label) {
 // the followings are private functions
 
 void DyckVertex::addSource(DyckVertex* ver, void* label) {
-	in_lables.insert(label);
-	in_vers[label].insert(ver);
+	in_vers.insert(label, ver);
 }
 
 void DyckVertex::removeSource(DyckVertex* ver, void* label) {
-    auto it = in_vers.find(label);
-    if (it != in_vers.end()) {
-        it->second.erase(ver);
-    }
+	in_vers.erase(label, ver);
 }
@@ -0,0 +1,55 @@
+; --dot-dyck-callgraph
+; checks: snapshot result-cache threads
+; ModuleID = 'snapshot.bc'
+target datalayout = "e-m:e-p:32:32-f64:32:64-f80:32-n8:16:32-S128"
+target triple = "i386-pc-linux-gnu"
+
+%struct.node = type { i32*, %struct.node* }
+
+@0 = internal global i32 0, align 4
+@head = global %struct.node* null, align 4
+@handler = global void (%struct.node*)* null, align 4
+
+; an unnamed function, whose arguments and instructions are kept by a snapshot
+; Function Attrs: nounwind
+define internal void @1(%struct.node* %n, i32* %v) #0 {
+entry:
+  %data = getelementptr inbounds %struct.node* %n, i32 0, i32 0
+  store i32* %v, i32** %data, align 4
+  %next = getelementptr inbounds %struct.node* %n, i32 0, i32 1
+  %0 = load %struct.node** @head, align 4
+  store %struct.node* %0, %struct.node** %next, align 4
+  store %struct.node* %n, %struct.node** @head, align 4
+  ret void
+}
+
+; Function Attrs: nounwind
+define void @visit(%struct.node* %n) #0 {
+entry:
+  %data = getelementptr inbounds %struct.node* %n, i32 0, i32 0
+  %0 = load i32** %data, align 4
+  store i32 1, i32* %0, align 4
+  ret void
+}
+
+; Function Attrs: nounwind
+declare noalias i8* @malloc(i32) #0
+
+; Function Attrs: nounwind
+define i32 @main() #0 {
+entry:
+  %local = alloca i32, align 4
+  %call = call noalias i8* @malloc(i32 8) #0
+  %0 = bitcast i8* %call to %struct.node*
+  call void @1(%struct.node* %0, i32* %local)
+  %call1 = call noalias i8* @malloc(i32 8) #0
+  %1 = bitcast i8* %call1 to %struct.node*
+  call void @1(%struct.node* %1, i32* @0)
+  store void (%struct.node*)* @visit, void (%struct.node*)** @handler, align 4
+  %2 = load void (%struct.node*)** @handler, align 4
+  %3 = load %struct.node** @head, align 4
+  call void %2(%struct.node* %3)
+  ret i32 0
+}
+
+attributes #0 = { nounwind }
@@ -0,0 +1,74 @@
+; --dot-dyck-callgraph
+; checks: summary-cache intra-threads
+; ModuleID = 'functions.bc'
+target datalayout = "e-m:e-p:32:32-f64:32:64-f80:32-n8:16:32-S128"
+target triple = "i386-pc-linux-gnu"
+
+%struct.pair = type { i32*, i32* }
+
+@a = global i32 0, align 4
+@b = global i32 0, align 4
+@table = global [2 x void (%struct.pair*)*] [void (%struct.pair*)* @fill, void (%struct.pair*)* @swap], align 4
+
+; Function Attrs: nounwind
+define void @fill(%struct.pair* %p) #0 {
+entry:
+  %first = getelementptr inbounds %struct.pair* %p, i32 0, i32 0
+  store i32* @a, i32** %first, align 4
+  %second = getelementptr inbounds %struct.pair* %p, i32 0, i32 1
+  store i32* @b, i32** %second, align 4
+  ret void
+}
+
+; Function Attrs: nounwind
+define void @swap(%struct.pair* %p) #0 {
+entry:
+  %first = getelementptr inbounds %struct.pair* %p, i32 0, i32 0
+  %second = getelementptr inbounds %struct.pair* %p, i32 0, i32 1
+  %0 = load i32** %first, align 4
+  %1 = load i32** %second, align 4
+  store i32* %1, i32** %first, align 4
+  store i32* %0, i32** %second, align 4
+  ret void
+}
+
+; Function Attrs: nounwind
+define i32* @pick(%struct.pair* %p, i32 %c) #0 {
+entry:
+  %tobool = icmp ne i32 %c, 0
+  %first = getelementptr inbounds %struct.pair* %p, i32 0, i32 0
+  %second = getelementptr inbounds %struct.pair* %p, i32 0, i32 1
+  %field = select i1 %tobool, i32** %first, i32** %second
+  %0 = load i32** %field, align 4
+  ret i32* %0
+}
+
+; Function Attrs: nounwind
+define void @copy(%struct.pair* %dst, %struct.pair* %src) #0 {
+entry:
+  %0 = bitcast %struct.pair* %dst to i8*
+  %1 = bitcast %struct.pair* %src to i8*
+  call void @llvm.memcpy.p0i8.p0i8.i32(i8* %0, i8* %1, i32 8, i32 4, i1 false)
+  ret void
+}
+
+; Function Attrs: nounwind
+declare void @llvm.memcpy.p0i8.p0i8.i32(i8* nocapture, i8* nocapture readonly, i32, i32, i1) #0
+
+; Function Attrs: nounwind
+define i32 @main(i32 %argc) #0 {
+entry:
+  %x = alloca %struct.pair, align 4
+  %y = alloca %struct.pair, align 4
+  call void @fill(%struct.pair* %x)
+  %idx = and i32 %argc, 1
+  %slot = getelementptr inbounds [2 x void (%struct.pair*)*]* @table, i32 0, i32 %idx
+  %0 = load void (%struct.pair*)** %slot, align 4
+  call void %0(%struct.pair* %x)
+  call void @copy(%struct.pair* %y, %struct.pair* %x)
+  %call = call i32* @pick(%struct.pair* %y, i32 %argc)
+  store i32 1, i32* %call, align 4
+  ret i32 0
+}
+
+attributes #0 = { nounwind }
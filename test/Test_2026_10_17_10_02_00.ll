@@ -0,0 +1,45 @@
+; -dyckaa-threads=1
+; checks: region=main
+; ModuleID = 'region.bc'
+target datalayout = "e-m:e-p:32:32-f64:32:64-f80:32-n8:16:32-S128"
+target triple = "i386-pc-linux-gnu"
+
+@shared = global i32* null, align 4
+@g = global i32 0, align 4
+
+; Function Attrs: nounwind
+define void @init(i32** %pp, i32* %v) #0 {
+entry:
+  store i32* %v, i32** %pp, align 4
+  ret void
+}
+
+; the sets of %b and %s are changed by @other, which is out of the region
+; Function Attrs: nounwind
+define i32 @main() #0 {
+entry:
+  %a = alloca i32, align 4
+  %b = alloca i32, align 4
+  %c = alloca i32, align 4
+  %p = alloca i32*, align 4
+  %p2 = alloca i32*, align 4
+  call void @init(i32** %p, i32* %a)
+  store i32* %c, i32** %p2, align 4
+  store i32* %b, i32** @shared, align 4
+  %q = load i32** %p, align 4
+  %r = load i32** %p2, align 4
+  %s = load i32** @shared, align 4
+  store i32 1, i32* %q, align 4
+  store i32 2, i32* %r, align 4
+  store i32 3, i32* %s, align 4
+  ret i32 0
+}
+
+; Function Attrs: nounwind
+define void @other() #0 {
+entry:
+  store i32* @g, i32** @shared, align 4
+  ret void
+}
+
+attributes #0 = { nounwind }
@@ -0,0 +1,35 @@
+; -dyckaa-threads=1
+; checks: field-limit=64
+; ModuleID = 'fields.bc'
+target datalayout = "e-m:e-p:32:32-f64:32:64-f80:32-n8:16:32-S128"
+target triple = "i386-pc-linux-gnu"
+
+; a table of 100 pointers, which is analyzed in bulk, where the fields 70 and 80
+; are one field with -dyckaa-field-limit=64
+%struct.table = type { i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32*, i32* }
+
+@a = global i32 0, align 4
+@b = global i32 0, align 4
+@c = global i32 0, align 4
+@d = global i32 0, align 4
+@table = global %struct.table { i32* @c, i32* @d, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* @a, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* @b, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null, i32* null }, align 4
+
+; Function Attrs: nounwind
+define i32 @main() #0 {
+entry:
+  %f0 = getelementptr inbounds %struct.table* @table, i32 0, i32 0
+  %f1 = getelementptr inbounds %struct.table* @table, i32 0, i32 1
+  %f70 = getelementptr inbounds %struct.table* @table, i32 0, i32 70
+  %f80 = getelementptr inbounds %struct.table* @table, i32 0, i32 80
+  %p0 = load i32** %f0, align 4
+  %p1 = load i32** %f1, align 4
+  %p70 = load i32** %f70, align 4
+  %p80 = load i32** %f80, align 4
+  store i32 1, i32* %p0, align 4
+  store i32 2, i32* %p1, align 4
+  store i32 3, i32* %p70, align 4
+  store i32 4, i32* %p80, align 4
+  ret i32 0
+}
+
+attributes #0 = { nounwind }
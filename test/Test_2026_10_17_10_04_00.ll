@@ -0,0 +1,28 @@
+; -dyckaa-threads=1
+; checks: queries
+; the field %fp of %st and the pointers loaded from them are partial aliases
+; query: 0:main 0 1 PartialAlias
+; query: 0:main 2 3 PartialAlias
+; ModuleID = 'partial.bc'
+target datalayout = "e-m:e-p:32:32-f64:32:64-f80:32-n8:16:32-S128"
+target triple = "i386-pc-linux-gnu"
+
+%struct.pair = type { i32, i32 }
+
+@ps = global %struct.pair* null, align 4
+@pf = global i32* null, align 4
+
+; Function Attrs: nounwind
+define i32 @main() #0 {
+entry:
+  %st = alloca %struct.pair, align 4
+  %fp = getelementptr inbounds %struct.pair* %st, i32 0, i32 1
+  store %struct.pair* %st, %struct.pair** @ps, align 4
+  store i32* %fp, i32** @pf, align 4
+  %a = load %struct.pair** @ps, align 4
+  %b = load i32** @pf, align 4
+  store i32 1, i32* %b, align 4
+  ret i32 0
+}
+
+attributes #0 = { nounwind }
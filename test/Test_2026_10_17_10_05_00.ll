@@ -0,0 +1,31 @@
+; -dyckaa-threads=1 -dyckaa-mem-alloca=slabs_alloc
+; checks: queries
+; slabs_alloc allocates %p, which %r is loaded from @gp, and %q by the pointer loaded from @allocator
+; query: 1:main 0 allocas p
+; query: 1:main 1 allocas slabs_alloc
+; query: 1:main 2 allocas q
+; query: 1:main 3 allocas p
+; ModuleID = 'allocas.bc'
+target datalayout = "e-m:e-p:32:32-f64:32:64-f80:32-n8:16:32-S128"
+target triple = "i386-pc-linux-gnu"
+
+@allocator = global i8* (i32)* @slabs_alloc, align 4
+@gp = global i8* null, align 4
+
+declare i8* @slabs_alloc(i32) #1
+
+; Function Attrs: nounwind
+define i32 @main() #0 {
+entry:
+  %p = call i8* @slabs_alloc(i32 8)
+  store i8* %p, i8** @gp, align 4
+  %f = load i8* (i32)** @allocator, align 4
+  %q = call i8* %f(i32 16)
+  %r = load i8** @gp, align 4
+  store i8 0, i8* %q, align 1
+  store i8 0, i8* %r, align 1
+  ret i32 0
+}
+
+attributes #0 = { nounwind }
+attributes #1 = { nounwind }
@@ -0,0 +1,29 @@
+; -dyckaa-threads=1
+; checks: library-models
+; strcpy returns its source instead of its destination by the models below
+; model: # the result of strcpy is its source
+; model: strcpy 2 alias ret 1
+; query: 2:main 0 allocas b
+; query: 2:main 1 allocas k
+; query: 2:main 2 allocas k
+; ModuleID = 'models.bc'
+target datalayout = "e-m:e-p:32:32-f64:32:64-f80:32-n8:16:32-S128"
+target triple = "i386-pc-linux-gnu"
+
+declare noalias i8* @malloc(i32) #1
+
+declare i8* @strcpy(i8*, i8*) #1
+
+; Function Attrs: nounwind
+define i32 @main() #0 {
+entry:
+  %b = call noalias i8* @malloc(i32 8)
+  %k = call noalias i8* @malloc(i32 8)
+  store i8 0, i8* %k, align 1
+  %r = call i8* @strcpy(i8* %b, i8* %k)
+  store i8 1, i8* %r, align 1
+  ret i32 0
+}
+
+attributes #0 = { nounwind }
+attributes #1 = { nounwind }
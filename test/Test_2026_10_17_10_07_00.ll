@@ -0,0 +1,29 @@
+; -dyckaa-threads=1
+; checks: summary-change
+; @g points to @a, and to @b after @set is changed
+; change: s/store i32\* %v, i32\*\* %pp/store i32* @b, i32** %pp/
+; ModuleID = 'change.bc'
+target datalayout = "e-m:e-p:32:32-f64:32:64-f80:32-n8:16:32-S128"
+target triple = "i386-pc-linux-gnu"
+
+@g = global i32* null, align 4
+@a = global i32 0, align 4
+@b = global i32 0, align 4
+
+; Function Attrs: nounwind
+define void @set(i32** %pp, i32* %v) #0 {
+entry:
+  store i32* %v, i32** %pp, align 4
+  ret void
+}
+
+; Function Attrs: nounwind
+define i32 @main() #0 {
+entry:
+  call void @set(i32** @g, i32* @a)
+  %p = load i32** @g, align 4
+  store i32 1, i32* %p, align 4
+  ret i32 0
+}
+
+attributes #0 = { nounwind }
@@ -1,15 +1,100 @@
 #!/bin/bash
 
+# Print the alias sets of alias_sets.log, one set per line, without the ids of
+# the sets and with the values and the sets sorted, so that the results of two
+# runs can be compared even if the sets are numbered differently.
+canonical_alias_sets() {
+    awk '/^[[{][0-9]+[]}]/ {
+            mark = substr($0, 1, 1); set = $0; sub(/^[[{][0-9]+[]}]/, "", $0);
+            sub(/[]}].*/, "", set); print substr(set, 2) "\t" mark $0 }' alias_sets.log \
+        | sort -t $'\t' -k1,1n -k2 \
+        | awk -F '\t' '$1 != last { if (NR > 1) print line; line = ""; last = $1 } { line = line $2 "\x01" }
+            END { if (NR > 0) print line }' \
+        | sort
+}
+
+# Run canary with the options on the test file, the alias sets are written into
+# $1, the alias queries into $1.queries and the messages of canary into $1.err.
+run_canary() {
+    local result=$1
+    shift
+    echo "Test: canary $option $@ $outputfile"
+    rm -f alias_sets.log alias_queries.log
+    canary $option "$@" $outputfile -o $outputfile > /dev/null 2> $result.err
+    exitcode=$?
+    if [ $exitcode != 0 ]; then
+        cat $result.err
+        echo "==============================================="
+        echo "Test Fail! Exit code: $exitcode."
+        exit -1;
+    fi
+    if [ -f alias_sets.log ]; then
+        canonical_alias_sets > $result
+    fi
+    if [ -f alias_queries.log ]; then
+        mv alias_queries.log $result.queries
+    fi
+}
+
+# Fail unless each answer of $2.queries is MayAlias or the one of $1.queries,
+# and some of them are not MayAlias. The allocation sites are not compared.
+expect_conservative() {
+    if ! awk '$3 == "allocas" { next }
+            NR == FNR { whole[$1 " " $2 " " $3] = $4; next }
+            $4 != "MayAlias" { precise++; if (whole[$1 " " $2 " " $3] != $4) { print; wrong++ } }
+            END { exit (wrong || !precise) }' $1.queries $2.queries; then
+        echo "==============================================="
+        echo "Test Fail! The alias queries of $2 are not conservative or all MayAlias."
+        exit -1;
+    fi
+}
+
+# Fail unless $1.queries has each line of the test file that starts with "; query: ".
+expect_queries() {
+    missing=`sed -n 's/^; query: //p' $file | grep -vxF -f $1.queries`
+    if [ -n "$missing" ]; then
+        echo "$missing"
+        echo "==============================================="
+        echo "Test Fail! The alias queries above are not in $1.queries."
+        exit -1;
+    fi
+}
+
+# Fail if the alias sets of two runs are different.
+expect_same() {
+    if ! cmp -s $1 $2; then
+        diff $1 $2 | head -20
+        echo "==============================================="
+        echo "Test Fail! The alias sets of $1 and $2 are different."
+        exit -1;
+    fi
+}
+
+# Fail if the messages of a run do not have the pattern, or have it if $3 is "not".
+expect_message() {
+    if grep -q "$2" $1.err; then
+        found=yes
+    else
+        found=no
+    fi
+    if [ "$3" == "not" -a $found == yes ] || [ "$3" != "not" -a $found == no ]; then
+        cat $1.err
+        echo "==============================================="
+        echo "Test Fail! Unexpected messages of $1."
+        exit -1;
+    fi
+}
+
 num=0
 for file in *.ll
 do
     num=$((num+1))
 
-    mkdir .test
+    mkdir -p .test
     clear
     outputfile=.test/${file%.*}.bc
     llvm-as $file -o $outputfile
-    
+
     option=`head -1 $file`
     option=${option:1}
 
@@ -22,9 +107,154 @@ do
         echo "Test Fail! Exit code: $exitcode."
         exit -1;
     fi
+
+    # the second line may list the runs that must give the same alias sets,
+    # e.g. "; checks: snapshot result-cache summary-cache intra-threads threads region=main field-limit=8 queries library-models summary-change"
+    checks=`sed -n '2s/^; checks://p' $file`
+    if [ -z "$checks" ]; then
+        continue
+    fi
+    result=.test/${file%.*}
+    run_canary $result.base -print-alias-set-info
+
+    for check in $checks
+    do
+        case $check in
+        snapshot)
+            # a snapshot gives the alias sets it is saved from
+            run_canary $result.save -print-alias-set-info -dyckaa-save-snapshot=$result.dsnap
+            expect_same $result.base $result.save
+            run_canary $result.load -print-alias-set-info -dyckaa-load-snapshot=$result.dsnap
+            expect_message $result.load "cannot be loaded" not
+            expect_same $result.base $result.load
+
+            # a snapshot with a corrupted header or truncated is rejected, and the module is analyzed
+            cp $result.dsnap $result.corrupted.dsnap
+            printf '\xff\xff\xff\xff' | dd of=$result.corrupted.dsnap bs=1 seek=12 conv=notrunc 2> /dev/null
+            run_canary $result.corrupted -print-alias-set-info -dyckaa-load-snapshot=$result.corrupted.dsnap
+            expect_message $result.corrupted "cannot be loaded"
+            expect_same $result.base $result.corrupted
+
+            head -c $((`stat -c %s $result.dsnap` / 2)) $result.dsnap > $result.truncated.dsnap
+            run_canary $result.truncated -print-alias-set-info -dyckaa-load-snapshot=$result.truncated.dsnap
+            expect_message $result.truncated "cannot be loaded"
+            expect_same $result.base $result.truncated
+            ;;
+        summary-cache)
+            # the summaries saved by a cold run give the same alias sets in a warm run
+            rm -rf $result.summaries
+            run_canary $result.cold -print-alias-set-info -dyckaa-summary-cache=$result.summaries
+            expect_same $result.base $result.cold
+            if [ -z "`ls $result.summaries`" ]; then
+                echo "==============================================="
+                echo "Test Fail! No summary is saved into $result.summaries."
+                exit -1;
+            fi
+            run_canary $result.warm -print-alias-set-info -dyckaa-summary-cache=$result.summaries
+            expect_same $result.cold $result.warm
+            ;;
+        summary-change)
+            # a function changed by the lines "; change: <sed command>" of the test file is
+            # analyzed again instead of using the summary saved before the change
+            rm -rf $result.summaries
+            run_canary $result.cold -print-alias-set-info -dyckaa-summary-cache=$result.summaries
+            sed -n 's/^; change: //p' $file > $result.sed
+            grep -v '^;' $file | sed -f $result.sed > $result.changed.ll
+            original=$outputfile
+            outputfile=$result.changed.bc
+            llvm-as $result.changed.ll -o $outputfile
+            run_canary $result.fresh -print-alias-set-info
+            run_canary $result.stale -print-alias-set-info -dyckaa-summary-cache=$result.summaries
+            outputfile=$original
+            expect_same $result.fresh $result.stale
+            if cmp -s $result.cold $result.fresh; then
+                echo "==============================================="
+                echo "Test Fail! No alias set is changed by $result.sed."
+                exit -1;
+            fi
+            ;;
+        result-cache)
+            # the result saved into the cache by a cold run gives the same alias sets in a warm run
+            rm -rf $result.results
+            run_canary $result.miss -print-alias-set-info -dyckaa-result-cache=$result.results
+            expect_same $result.base $result.miss
+            run_canary $result.hit -print-alias-set-info -dyckaa-result-cache=$result.results
+            expect_same $result.miss $result.hit
+            ;;
+        region=*)
+            # a region answers MayAlias or the answer of the whole analysis
+            run_canary $result.whole -print-alias-queries
+            run_canary $result.region -print-alias-queries -dyckaa-region=${check#region=}
+            expect_conservative $result.whole $result.region
+            ;;
+        threads)
+            # the graph normalized in parallel, even for few pairs to merge, gives the same alias sets
+            run_canary $result.dthreads1 -print-alias-set-info -dyckaa-threads=1
+            run_canary $result.dthreads4 -print-alias-set-info -dyckaa-threads=4 -dyckaa-min-parallel-obligations=1
+            expect_same $result.base $result.dthreads1
+            expect_same $result.dthreads1 $result.dthreads4
+            ;;
+        queries)
+            # the lines "; query: <function> <pointer> <pointer> <result>" or
+            # "; query: <function> <pointer> allocas <sites>" of the test file are answered
+            run_canary $result.asked -print-alias-queries
+            expect_queries $result.asked
+            ;;
+        library-models)
+            # the lines "; model: <model>" of the test file replace the built-in models of their functions
+            sed -n 's/^; model: //p' $file > $result.models
+            run_canary $result.builtin -print-alias-queries
+            run_canary $result.modeled -print-alias-queries -library-models=$result.models
+            expect_message $result.modeled "are not loaded" not
+            expect_queries $result.modeled
+            if cmp -s $result.builtin.queries $result.modeled.queries; then
+                echo "==============================================="
+                echo "Test Fail! No alias query is changed by $result.models."
+                exit -1;
+            fi
+
+            # a file with a malformed line is not loaded, and the built-in models are used
+            printf '# a kind without operands\n\nf 2 alias\n' > $result.malformed.models
+            run_canary $result.malformed -print-alias-queries -library-models=$result.malformed.models
+            expect_message $result.malformed "line 3 is malformed"
+            expect_same $result.builtin.queries $result.malformed.queries
+            ;;
+        field-limit=*)
+            # the fields from the limit are one field, whether the table is analyzed in bulk or not
+            limit=-dyckaa-field-limit=${check#field-limit=}
+            run_canary $result.whole -print-alias-queries
+            run_canary $result.collapsed -print-alias-queries $limit
+            run_canary $result.unbulked -print-alias-queries $limit -dyckaa-bulk-aggregate=0
+            expect_conservative $result.whole $result.collapsed
+            expect_same $result.collapsed.queries $result.unbulked.queries
+            if cmp -s $result.whole.queries $result.collapsed.queries; then
+                echo "==============================================="
+                echo "Test Fail! No alias query is changed by $limit."
+                exit -1;
+            fi
+            # the statistics are only printed by a canary built with assertions
+            if canary -help-hidden 2>&1 | grep -q "debug-only"; then
+                run_canary $result.stats $limit -debug-only=dyckaa-stats
+                expect_message $result.stats "# Collapsed fields: [1-9]"
+            fi
+            ;;
+        intra-threads)
+            # the functions analyzed in parallel give the same alias sets
+            run_canary $result.threads1 -print-alias-set-info -dyckaa-intra-threads=1
+            run_canary $result.threads4 -print-alias-set-info -dyckaa-intra-threads=4
+            expect_same $result.base $result.threads1
+            expect_same $result.threads1 $result.threads4
+            ;;
+        *)
+            echo "==============================================="
+            echo "Test Fail! Unknown check $check in $file."
+            exit -1;
+            ;;
+        esac
+    done
 done
 
-rm -rf .test/
+rm -rf .test/ alias_sets.log alias_queries.log alias_rel.dot distribution.log
 
 echo "==============================================="
 echo "Congradulations! All ($num) tests passed!"